@@ -0,0 +1,57 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+// fixed-response server for libnode-bench.
+// usage: libnode-bench-server [PORT [BODY_SIZE]]
+
+#include <stdlib.h>
+#include <string>
+
+#include "libnode/http_server.h"
+#include "libnode/http_server_request.h"
+#include "libnode/http_server_response.h"
+#include "libnode/node.h"
+
+namespace libj {
+namespace node {
+
+class OnRequest : LIBJ_JS_FUNCTION(OnRequest)
+ private:
+    String::CPtr body_;
+
+ public:
+    OnRequest(String::CPtr body) : body_(body) {}
+
+    Value operator()(JsArray::Ptr args) {
+        static const String::CPtr contentType =
+            String::create("Content-Type");
+        static const String::CPtr textPlain =
+            String::create("text/plain");
+
+        http::ServerResponse::Ptr res =
+            toPtr<http::ServerResponse>(args->get(1));
+        res->setHeader(contentType, textPlain);
+        res->write(body_);
+        res->end();
+        return 0;
+    }
+};
+
+}  // namespace node
+}  // namespace libj
+
+int main(int argc, char *argv[]) {
+    namespace node = libj::node;
+    namespace http = libj::node::http;
+
+    int port = argc > 1 ? atoi(argv[1]) : 10000;
+    size_t size = argc > 2 ? strtoul(argv[2], 0, 10) : 13;
+    std::string body = size == 13 ? "Hello, World!" : std::string(size, 'x');
+
+    node::OnRequest::Ptr onRequest(
+        new node::OnRequest(libj::String::create(body.c_str())));
+    http::Server::Ptr server = http::Server::create(onRequest);
+    if (!server->listen(port))
+        return 1;
+    node::run();
+    return 0;
+}
@@ -0,0 +1,632 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+// HTTP load generator for libnode servers.
+//
+// closed loop (default): every connection keeps --pipeline requests in
+// flight and sends the next one as soon as a response arrives.
+// open loop (--rate): requests are scheduled at a fixed aggregate rate and
+// latency is measured from the intended send time, so a stalled server is
+// charged for the requests it delayed (coordinated omission).
+
+#include <getopt.h>
+#include <http_parser.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uv.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "./latency_histogram.h"
+
+namespace libj {
+namespace node {
+namespace bench {
+
+struct RequestTemplate {
+    std::string method;
+    std::string path;
+    size_t bodySize;
+    unsigned weight;
+    std::string bytes;
+    bool isHead;
+};
+
+struct Options {
+    std::string host;
+    int port;
+    int connections;
+    int pipeline;
+    bool keepAlive;
+    double duration;
+    double warmup;
+    double rate;
+    uint64_t expectedInterval;
+    uint64_t seed;
+    std::vector<RequestTemplate> requests;
+};
+
+struct InFlight {
+    uint64_t intended;
+    uint64_t sent;
+    size_t request;
+};
+
+struct Stats {
+    Stats()
+        : completed(0)
+        , bytesRead(0)
+        , connectErrors(0)
+        , readErrors(0)
+        , parseErrors(0)
+        , reconnects(0)
+        , non2xx(0) {}
+
+    uint64_t completed;
+    uint64_t bytesRead;
+    uint64_t connectErrors;
+    uint64_t readErrors;
+    uint64_t parseErrors;
+    uint64_t reconnects;
+    uint64_t non2xx;
+    LatencyHistogram latency;
+    LatencyHistogram serviceTime;
+};
+
+class Generator;
+
+struct Connection {
+    uv_tcp_t tcp;
+    uv_connect_t connectReq;
+    http_parser parser;
+    Generator* gen;
+    bool connected;
+    bool closing;
+    bool closeAfterResponse;
+    std::deque<InFlight> inflight;
+    std::deque<InFlight> backlog;
+};
+
+struct WriteReq {
+    uv_write_t req;
+    WriteReq* next;
+};
+
+class Generator {
+ public:
+    explicit Generator(const Options& opts)
+        : opts_(opts)
+        , loop_(uv_default_loop())
+        , conns_(opts.connections)
+        , freeWrites_(0)
+        , rng_(opts.seed ? opts.seed : 88172645463325252ULL)
+        , totalWeight_(0)
+        , stopping_(false)
+        , startTime_(0)
+        , measureFrom_(0)
+        , endTime_(0)
+        , nextIntended_(0)
+        , interval_(0)
+        , roundRobin_(0) {
+        settings_.on_message_begin = 0;
+        settings_.on_url = 0;
+        settings_.on_header_field = 0;
+        settings_.on_header_value = 0;
+        settings_.on_headers_complete = Generator::onHeadersComplete;
+        settings_.on_body = 0;
+        settings_.on_message_complete = Generator::onMessageComplete;
+        for (size_t i = 0; i < opts_.requests.size(); i++)
+            totalWeight_ += opts_.requests[i].weight;
+        if (opts_.rate > 0)
+            interval_ = static_cast<uint64_t>(1e9 / opts_.rate);
+    }
+
+    ~Generator() {
+        while (freeWrites_) {
+            WriteReq* w = freeWrites_;
+            freeWrites_ = w->next;
+            delete w;
+        }
+    }
+
+    void run() {
+        startTime_ = uv_hrtime();
+        measureFrom_ = startTime_ + static_cast<uint64_t>(opts_.warmup * 1e9);
+        endTime_ = measureFrom_ + static_cast<uint64_t>(opts_.duration * 1e9);
+        nextIntended_ = startTime_;
+
+        for (size_t i = 0; i < conns_.size(); i++) {
+            conns_[i].gen = this;
+            connect(&conns_[i]);
+        }
+
+        uv_timer_init(loop_, &ticker_);
+        ticker_.data = this;
+        uv_timer_start(&ticker_, Generator::onTick, 1, 1);
+
+        uv_run(loop_);
+    }
+
+    void report() const {
+        double secs = opts_.duration;
+        printf("target     %s:%d, %d connections, pipeline %d, %s\n",
+            opts_.host.c_str(), opts_.port, opts_.connections,
+            opts_.pipeline, opts_.keepAlive ? "keep-alive" : "close");
+        if (opts_.rate > 0) {
+            printf("mode       open loop, %.0f req/s target\n", opts_.rate);
+        } else {
+            printf("mode       closed loop\n");
+        }
+        printf("requests   %llu in %.2fs (%.0f req/s, %.2f MB/s)\n",
+            static_cast<unsigned long long>(stats_.completed),
+            secs,
+            stats_.completed / secs,
+            stats_.bytesRead / secs / (1024 * 1024));
+        printf("errors     connect %llu, read %llu, parse %llu, "
+               "non-2xx %llu, reconnects %llu\n",
+            static_cast<unsigned long long>(stats_.connectErrors),
+            static_cast<unsigned long long>(stats_.readErrors),
+            static_cast<unsigned long long>(stats_.parseErrors),
+            static_cast<unsigned long long>(stats_.non2xx),
+            static_cast<unsigned long long>(stats_.reconnects));
+
+        if (opts_.rate > 0) {
+            printLatency("latency (from intended send time)", stats_.latency);
+            printLatency("service time (from actual send)", stats_.serviceTime);
+        } else {
+            uint64_t expected = opts_.expectedInterval;
+            if (!expected)
+                expected = stats_.serviceTime.percentile(50);
+            printLatency("latency (uncorrected)", stats_.serviceTime);
+            printf("expected interval %.1fus\n", expected / 1e3);
+            printLatency(
+                "latency (corrected for coordinated omission)",
+                stats_.serviceTime.corrected(expected));
+        }
+    }
+
+ private:
+    static void printLatency(const char* title, const LatencyHistogram& h) {
+        static const double ps[] = { 50, 75, 90, 99, 99.9, 99.99, 100 };
+        printf("%s\n", title);
+        printf("    mean %10.1fus  min %10.1fus  (%llu samples)\n",
+            h.mean() / 1e3, h.min() / 1e3,
+            static_cast<unsigned long long>(h.count()));
+        for (size_t i = 0; i < sizeof(ps) / sizeof(ps[0]); i++) {
+            printf("    p%-7g %10.1fus\n", ps[i], h.percentile(ps[i]) / 1e3);
+        }
+    }
+
+    uint64_t nextRandom() {
+        // xorshift64, seeded for reproducible request mixes
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 7;
+        rng_ ^= rng_ << 17;
+        return rng_;
+    }
+
+    size_t pickRequest() {
+        if (opts_.requests.size() == 1)
+            return 0;
+        uint64_t r = nextRandom() % totalWeight_;
+        for (size_t i = 0; i < opts_.requests.size(); i++) {
+            if (r < opts_.requests[i].weight)
+                return i;
+            r -= opts_.requests[i].weight;
+        }
+        return 0;
+    }
+
+    void connect(Connection* c) {
+        uv_tcp_init(loop_, &c->tcp);
+        uv_tcp_nodelay(&c->tcp, 1);
+        c->tcp.data = c;
+        c->connectReq.data = c;
+        c->connected = false;
+        c->closing = false;
+        c->closeAfterResponse = false;
+        http_parser_init(&c->parser, HTTP_RESPONSE);
+        c->parser.data = c;
+        if (uv_tcp_connect(
+                &c->connectReq,
+                &c->tcp,
+                uv_ip4_addr(opts_.host.c_str(), opts_.port),
+                Generator::onConnect)) {
+            stats_.connectErrors++;
+            close(c);
+        }
+    }
+
+    void close(Connection* c) {
+        if (c->closing)
+            return;
+        c->closing = true;
+        uv_close(
+            reinterpret_cast<uv_handle_t*>(&c->tcp),
+            Generator::onClose);
+    }
+
+    void stop() {
+        stopping_ = true;
+        uv_timer_stop(&ticker_);
+        uv_close(reinterpret_cast<uv_handle_t*>(&ticker_), 0);
+        for (size_t i = 0; i < conns_.size(); i++)
+            close(&conns_[i]);
+    }
+
+    void send(Connection* c, InFlight f) {
+        WriteReq* w = freeWrites_;
+        if (w) {
+            freeWrites_ = w->next;
+        } else {
+            w = new WriteReq;
+        }
+        w->req.data = this;
+
+        const RequestTemplate& t = opts_.requests[f.request];
+        uv_buf_t buf;
+        buf.base = const_cast<char*>(t.bytes.data());
+        buf.len = t.bytes.length();
+        f.sent = uv_hrtime();
+        c->inflight.push_back(f);
+        if (uv_write(
+                &w->req,
+                reinterpret_cast<uv_stream_t*>(&c->tcp),
+                &buf,
+                1,
+                Generator::afterWrite)) {
+            w->next = freeWrites_;
+            freeWrites_ = w;
+            stats_.readErrors++;
+            close(c);
+        }
+    }
+
+    // fills the connection up to the pipeline depth
+    void pump(Connection* c) {
+        if (!c->connected || c->closing || c->closeAfterResponse)
+            return;
+        size_t depth = opts_.keepAlive ? opts_.pipeline : 1;
+        while (c->inflight.size() < depth) {
+            InFlight f;
+            if (opts_.rate > 0) {
+                if (c->backlog.empty())
+                    break;
+                f = c->backlog.front();
+                c->backlog.pop_front();
+            } else {
+                if (stopping_ || uv_hrtime() >= endTime_)
+                    break;
+                f.intended = uv_hrtime();
+                f.request = pickRequest();
+            }
+            send(c, f);
+            if (!opts_.keepAlive)
+                c->closeAfterResponse = true;
+        }
+    }
+
+    // distributes the requests that became due among the connections
+    void schedule(uint64_t now) {
+        size_t n = conns_.size();
+        while (nextIntended_ <= now && nextIntended_ < endTime_) {
+            Connection* c = &conns_[roundRobin_++ % n];
+            InFlight f;
+            f.intended = nextIntended_;
+            f.sent = 0;
+            f.request = pickRequest();
+            c->backlog.push_back(f);
+            nextIntended_ += interval_;
+        }
+    }
+
+    bool drained() const {
+        for (size_t i = 0; i < conns_.size(); i++) {
+            if (!conns_[i].inflight.empty() || !conns_[i].backlog.empty())
+                return false;
+        }
+        return true;
+    }
+
+    void onResponse(Connection* c) {
+        uint64_t now = uv_hrtime();
+        if (c->inflight.empty()) {
+            stats_.parseErrors++;
+            return;
+        }
+        InFlight f = c->inflight.front();
+        c->inflight.pop_front();
+        if (c->parser.status_code < 200 || c->parser.status_code >= 300)
+            stats_.non2xx++;
+        if (f.intended >= measureFrom_ && f.intended < endTime_) {
+            stats_.completed++;
+            stats_.latency.record(now - f.intended);
+            stats_.serviceTime.record(now - f.sent);
+        }
+        if (!http_should_keep_alive(&c->parser))
+            c->closeAfterResponse = true;
+    }
+
+    static void onTick(uv_timer_t* handle, int status) {
+        Generator* self = static_cast<Generator*>(handle->data);
+        uint64_t now = uv_hrtime();
+        if (self->opts_.rate > 0)
+            self->schedule(now);
+        for (size_t i = 0; i < self->conns_.size(); i++)
+            self->pump(&self->conns_[i]);
+        // allow one second for the responses still in flight
+        if (now >= self->endTime_ &&
+            (self->drained() || now >= self->endTime_ + 1000000000ULL)) {
+            self->stop();
+        }
+    }
+
+    static void onConnect(uv_connect_t* req, int status) {
+        Connection* c = static_cast<Connection*>(req->data);
+        Generator* self = c->gen;
+        if (c->closing)
+            return;
+        if (status) {
+            self->stats_.connectErrors++;
+            self->close(c);
+            return;
+        }
+        c->connected = true;
+        uv_read_start(
+            reinterpret_cast<uv_stream_t*>(&c->tcp),
+            Generator::onAlloc,
+            Generator::onRead);
+        // requests lost with a previous connection are sent again
+        while (!c->inflight.empty()) {
+            c->backlog.push_front(c->inflight.back());
+            c->inflight.pop_back();
+        }
+        if (self->opts_.rate <= 0)
+            c->backlog.clear();
+        self->pump(c);
+    }
+
+    static uv_buf_t onAlloc(uv_handle_t* handle, size_t suggestedSize) {
+        static char slab[64 * 1024];
+        uv_buf_t buf;
+        buf.base = slab;
+        buf.len = sizeof(slab);
+        return buf;
+    }
+
+    static void onRead(uv_stream_t* stream, ssize_t nread, uv_buf_t buf) {
+        Connection* c = static_cast<Connection*>(stream->data);
+        Generator* self = c->gen;
+        if (nread < 0) {
+            uv_err_t err = uv_last_error(self->loop_);
+            if (err.code != UV_EOF)
+                self->stats_.readErrors++;
+            self->close(c);
+            return;
+        }
+        self->stats_.bytesRead += nread;
+        size_t parsed = http_parser_execute(
+                            &c->parser,
+                            &self->settings_,
+                            buf.base,
+                            nread);
+        if (parsed < static_cast<size_t>(nread)) {
+            self->stats_.parseErrors++;
+            self->close(c);
+        } else if (c->closeAfterResponse && c->inflight.empty()) {
+            self->close(c);
+        } else {
+            self->pump(c);
+        }
+    }
+
+    static void afterWrite(uv_write_t* req, int status) {
+        Generator* self = static_cast<Generator*>(req->data);
+        WriteReq* w = reinterpret_cast<WriteReq*>(req);
+        w->next = self->freeWrites_;
+        self->freeWrites_ = w;
+    }
+
+    static void onClose(uv_handle_t* handle) {
+        Connection* c = static_cast<Connection*>(handle->data);
+        Generator* self = c->gen;
+        if (self->stopping_)
+            return;
+        self->stats_.reconnects++;
+        self->connect(c);
+    }
+
+    static int onHeadersComplete(http_parser* parser) {
+        Connection* c = static_cast<Connection*>(parser->data);
+        if (c->inflight.empty())
+            return 0;
+        // responses to HEAD have no body
+        return c->gen->opts_.requests[c->inflight.front().request].isHead;
+    }
+
+    static int onMessageComplete(http_parser* parser) {
+        Connection* c = static_cast<Connection*>(parser->data);
+        c->gen->onResponse(c);
+        return 0;
+    }
+
+    Options opts_;
+    uv_loop_t* loop_;
+    uv_timer_t ticker_;
+    http_parser_settings settings_;
+    std::vector<Connection> conns_;
+    WriteReq* freeWrites_;
+    uint64_t rng_;
+    uint64_t totalWeight_;
+    bool stopping_;
+    uint64_t startTime_;
+    uint64_t measureFrom_;
+    uint64_t endTime_;
+    uint64_t nextIntended_;
+    uint64_t interval_;
+    size_t roundRobin_;
+    Stats stats_;
+};
+
+// METHOD:PATH[:BODY_SIZE[:WEIGHT]]
+static bool parseRequest(const char* spec, RequestTemplate* t) {
+    std::string s(spec);
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    while (true) {
+        size_t colon = s.find(':', pos);
+        fields.push_back(s.substr(pos, colon - pos));
+        if (colon == std::string::npos)
+            break;
+        pos = colon + 1;
+    }
+    if (fields.size() < 2 || fields[0].empty() || fields[1].empty())
+        return false;
+    t->method = fields[0];
+    t->path = fields[1];
+    t->bodySize = fields.size() > 2 ? strtoul(fields[2].c_str(), 0, 10) : 0;
+    t->weight = fields.size() > 3 ? strtoul(fields[3].c_str(), 0, 10) : 1;
+    t->isHead = t->method == "HEAD";
+    return t->weight > 0;
+}
+
+static void renderRequest(const Options& opts, RequestTemplate* t) {
+    char line[64];
+    std::string& r = t->bytes;
+    r = t->method + " " + t->path + " HTTP/1.1\r\n";
+    snprintf(line, sizeof(line), "%d", opts.port);
+    r += "Host: " + opts.host + ":" + line + "\r\n";
+    r += "User-Agent: libnode-bench\r\n";
+    if (!opts.keepAlive)
+        r += "Connection: close\r\n";
+    if (t->bodySize) {
+        snprintf(line, sizeof(line), "Content-Length: %lu\r\n",
+            static_cast<unsigned long>(t->bodySize));
+        r += line;
+    }
+    r += "\r\n";
+    r.append(t->bodySize, 'x');
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -h, --host ADDR          server address (127.0.0.1)\n"
+        "  -p, --port PORT          server port (10000)\n"
+        "  -c, --connections N      concurrent connections (16)\n"
+        "  -P, --pipeline N         requests in flight per connection (1)\n"
+        "  -k, --no-keepalive       one request per connection\n"
+        "  -d, --duration SECS      measured duration (10)\n"
+        "  -w, --warmup SECS        unmeasured warm-up period (2)\n"
+        "  -r, --rate REQ/S         open loop at a fixed aggregate rate\n"
+        "  -i, --interval USECS     expected interval for closed-loop\n"
+        "                           correction (default: median latency)\n"
+        "  -s, --seed N             seed of the request mix\n"
+        "  -R, --request SPEC       METHOD:PATH[:BODY_SIZE[:WEIGHT]],\n"
+        "                           repeatable (GET:/)\n",
+        prog);
+}
+
+static bool parseOptions(int argc, char** argv, Options* opts) {
+    static const struct option longOpts[] = {
+        { "host", required_argument, 0, 'h' },
+        { "port", required_argument, 0, 'p' },
+        { "connections", required_argument, 0, 'c' },
+        { "pipeline", required_argument, 0, 'P' },
+        { "no-keepalive", no_argument, 0, 'k' },
+        { "duration", required_argument, 0, 'd' },
+        { "warmup", required_argument, 0, 'w' },
+        { "rate", required_argument, 0, 'r' },
+        { "interval", required_argument, 0, 'i' },
+        { "seed", required_argument, 0, 's' },
+        { "request", required_argument, 0, 'R' },
+        { 0, 0, 0, 0 },
+    };
+
+    opts->host = "127.0.0.1";
+    opts->port = 10000;
+    opts->connections = 16;
+    opts->pipeline = 1;
+    opts->keepAlive = true;
+    opts->duration = 10;
+    opts->warmup = 2;
+    opts->rate = 0;
+    opts->expectedInterval = 0;
+    opts->seed = 0;
+
+    int ch;
+    RequestTemplate t;
+    while ((ch = getopt_long(
+            argc, argv, "h:p:c:P:kd:w:r:i:s:R:", longOpts, 0)) != -1) {
+        switch (ch) {
+        case 'h':
+            opts->host = optarg;
+            break;
+        case 'p':
+            opts->port = atoi(optarg);
+            break;
+        case 'c':
+            opts->connections = atoi(optarg);
+            break;
+        case 'P':
+            opts->pipeline = atoi(optarg);
+            break;
+        case 'k':
+            opts->keepAlive = false;
+            break;
+        case 'd':
+            opts->duration = atof(optarg);
+            break;
+        case 'w':
+            opts->warmup = atof(optarg);
+            break;
+        case 'r':
+            opts->rate = atof(optarg);
+            break;
+        case 'i':
+            opts->expectedInterval =
+                static_cast<uint64_t>(atof(optarg) * 1e3);
+            break;
+        case 's':
+            opts->seed = strtoull(optarg, 0, 10);
+            break;
+        case 'R':
+            if (!parseRequest(optarg, &t))
+                return false;
+            opts->requests.push_back(t);
+            break;
+        default:
+            return false;
+        }
+    }
+    if (opts->connections <= 0 || opts->pipeline <= 0 ||
+        opts->duration <= 0 || opts->warmup < 0)
+        return false;
+    if (opts->requests.empty()) {
+        parseRequest("GET:/", &t);
+        opts->requests.push_back(t);
+    }
+    for (size_t i = 0; i < opts->requests.size(); i++)
+        renderRequest(*opts, &opts->requests[i]);
+    return true;
+}
+
+}  // namespace bench
+}  // namespace node
+}  // namespace libj
+
+int main(int argc, char** argv) {
+    namespace bench = libj::node::bench;
+
+    bench::Options opts;
+    if (!bench::parseOptions(argc, argv, &opts)) {
+        bench::usage(argv[0]);
+        return 1;
+    }
+
+    bench::Generator gen(opts);
+    gen.run();
+    gen.report();
+    return 0;
+}
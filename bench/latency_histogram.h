@@ -0,0 +1,134 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef BENCH_LATENCY_HISTOGRAM_H_
+#define BENCH_LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace libj {
+namespace node {
+namespace bench {
+
+// log-linear histogram of nanosecond values.
+// values below 2048 are exact, larger values keep 10 significant bits
+// (relative error < 0.1%) up to 2^42 ns.
+class LatencyHistogram {
+ public:
+    LatencyHistogram()
+        : counts_(kNumBuckets, 0)
+        , total_(0)
+        , sum_(0)
+        , min_(~static_cast<uint64_t>(0))
+        , max_(0) {}
+
+    void record(uint64_t value) {
+        record(value, 1);
+    }
+
+    void record(uint64_t value, uint64_t count) {
+        counts_[indexOf(value)] += count;
+        total_ += count;
+        sum_ += static_cast<double>(value) * count;
+        if (value < min_) min_ = value;
+        if (value > max_) max_ = value;
+    }
+
+    // back-fills the samples a stalled closed-loop client failed to take
+    // (coordinated omission), as HdrHistogram does.
+    void recordCorrected(uint64_t value, uint64_t expectedInterval) {
+        record(value);
+        if (!expectedInterval || value <= expectedInterval)
+            return;
+        for (uint64_t missing = value - expectedInterval;
+             missing >= expectedInterval;
+             missing -= expectedInterval) {
+            record(missing);
+        }
+    }
+
+    void add(const LatencyHistogram& other) {
+        for (size_t i = 0; i < kNumBuckets; i++)
+            counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        sum_ += other.sum_;
+        if (other.min_ < min_) min_ = other.min_;
+        if (other.max_ > max_) max_ = other.max_;
+    }
+
+    LatencyHistogram corrected(uint64_t expectedInterval) const {
+        LatencyHistogram h;
+        for (size_t i = 0; i < kNumBuckets; i++) {
+            uint64_t n = counts_[i];
+            if (!n) continue;
+            uint64_t v = valueOf(i);
+            for (uint64_t j = 0; j < n; j++)
+                h.recordCorrected(v, expectedInterval);
+        }
+        return h;
+    }
+
+    uint64_t count() const { return total_; }
+
+    uint64_t min() const { return total_ ? min_ : 0; }
+
+    uint64_t max() const { return max_; }
+
+    double mean() const {
+        return total_ ? sum_ / total_ : 0;
+    }
+
+    uint64_t percentile(double p) const {
+        if (!total_)
+            return 0;
+        uint64_t target = static_cast<uint64_t>(p / 100.0 * total_ + 0.5);
+        if (target < 1) target = 1;
+        if (target > total_) target = total_;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kNumBuckets; i++) {
+            seen += counts_[i];
+            if (seen >= target) {
+                uint64_t v = valueOf(i);
+                return v > max_ ? max_ : v;
+            }
+        }
+        return max_;
+    }
+
+ private:
+    static const size_t kSubBits = 10;
+    static const size_t kSubCount = 1 << kSubBits;
+    static const size_t kMaxShift = 32;
+    static const size_t kNumBuckets = (kMaxShift + 2) * kSubCount;
+
+    static size_t indexOf(uint64_t value) {
+        if (value < 2 * kSubCount)
+            return static_cast<size_t>(value);
+        size_t shift = 63 - __builtin_clzll(value) - kSubBits;
+        if (shift > kMaxShift)
+            return kNumBuckets - 1;
+        return shift * kSubCount + static_cast<size_t>(value >> shift);
+    }
+
+    // the highest value that maps to the bucket
+    static uint64_t valueOf(size_t index) {
+        if (index < 2 * kSubCount)
+            return index;
+        size_t shift = index / kSubCount - 1;
+        uint64_t sub = index - shift * kSubCount;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_;
+    double sum_;
+    uint64_t min_;
+    uint64_t max_;
+};
+
+}  // namespace bench
+}  // namespace node
+}  // namespace libj
+
+#endif  // BENCH_LATENCY_HISTOGRAM_H_
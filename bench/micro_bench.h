@@ -0,0 +1,56 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef BENCH_MICRO_BENCH_H_
+#define BENCH_MICRO_BENCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace libj {
+namespace node {
+namespace bench {
+
+class MicroBench {
+ public:
+    explicit MicroBench(const char* name);
+
+    virtual ~MicroBench() {}
+
+    const char* name() const { return name_; }
+
+    // runs the operation n times.
+    // setup done before startTiming() is excluded from the results.
+    virtual void run(size_t n) = 0;
+
+ private:
+    const char* name_;
+};
+
+void startTiming();
+
+// allocations made through malloc/operator new so far
+uint64_t allocationCount();
+uint64_t allocationBytes();
+
+// a target for the allocated bytes/op of the running benchmark, which is
+// reported next to its result. the run exits with 1 if one is missed.
+void setBytesTarget(uint64_t bytes);
+
+// keeps the optimizer from discarding a result
+void doNotOptimize(const void* p);
+
+}  // namespace bench
+}  // namespace node
+}  // namespace libj
+
+#define LIBNODE_MICRO_BENCH(CASE, NAME) \
+    class CASE##_##NAME##_MicroBench \
+        : public libj::node::bench::MicroBench { \
+     public: \
+        CASE##_##NAME##_MicroBench() : MicroBench(#CASE "." #NAME) {} \
+        void run(size_t n); \
+    }; \
+    static CASE##_##NAME##_MicroBench CASE##_##NAME##_microBench; \
+    void CASE##_##NAME##_MicroBench::run(size_t n)
+
+#endif  // BENCH_MICRO_BENCH_H_
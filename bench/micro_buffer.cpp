@@ -0,0 +1,202 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include "libnode/buffer.h"
+#include "libnode/buffer_cursor.h"
+#include "libnode/buffer_list.h"
+#include "libnode/multipart.h"
+#include "./micro_bench.h"
+
+namespace libj {
+namespace node {
+
+static const Size kBufferSize = 4096;
+
+LIBNODE_MICRO_BENCH(Buffer, Create64) {
+    for (size_t i = 0; i < n; i++) {
+        Buffer::Ptr buf = Buffer::create(64);
+        bench::doNotOptimize(&*buf);
+    }
+}
+
+LIBNODE_MICRO_BENCH(Buffer, CreateFromString) {
+    String::CPtr str = String::create("GET /index.html HTTP/1.1");
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        Buffer::Ptr buf = Buffer::create(str);
+        bench::doNotOptimize(&*buf);
+    }
+}
+
+LIBNODE_MICRO_BENCH(Buffer, Slice) {
+    Buffer::Ptr buf = Buffer::create(kBufferSize);
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        Buffer::Ptr s = buf->slice(i % kBufferSize, kBufferSize);
+        bench::doNotOptimize(&*s);
+    }
+}
+
+LIBNODE_MICRO_BENCH(Buffer, Base64Encode) {
+    Buffer::Ptr buf = Buffer::create(kBufferSize);
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        String::CPtr s = buf->toString(Buffer::BASE64);
+        bench::doNotOptimize(&*s);
+    }
+}
+
+LIBNODE_MICRO_BENCH(Buffer, Base64Decode) {
+    String::CPtr str =
+        Buffer::create(kBufferSize)->toString(Buffer::BASE64);
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        Buffer::Ptr buf = Buffer::create(str, Buffer::BASE64);
+        bench::doNotOptimize(&*buf);
+    }
+}
+
+LIBNODE_MICRO_BENCH(Buffer, IndexOf) {
+    Buffer::Ptr buf = Buffer::create(kBufferSize);
+    buf->fill('-');
+    buf->write(String::create("\r\n\r\n"), kBufferSize - 4);
+    String::CPtr needle = String::create("\r\n\r\n");
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        Size pos = buf->indexOf(needle);
+        bench::doNotOptimize(&pos);
+    }
+}
+
+LIBNODE_MICRO_BENCH(Buffer, ListAppendFlatten) {
+    Buffer::Ptr chunk = Buffer::create(kBufferSize);
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        BufferList list;
+        for (Size j = 0; j < 16; j++)
+            list.append(chunk);
+        Buffer::Ptr body = list.flatten();
+        bench::doNotOptimize(&*body);
+    }
+}
+
+LIBNODE_MICRO_BENCH(Buffer, MultipartParse) {
+    String::CPtr boundary =
+        String::create("----FormBoundary7MA4YWxkTrZu0gW");
+    Buffer::Ptr head = Buffer::create(String::create(
+        "------FormBoundary7MA4YWxkTrZu0gW\r\n"
+        "Content-Disposition: form-data; name=\"f\"; filename=\"a\"\r\n"
+        "\r\n"));
+    Buffer::Ptr tail = Buffer::create(String::create(
+        "\r\n------FormBoundary7MA4YWxkTrZu0gW--\r\n"));
+    Buffer::Ptr chunk = Buffer::create(kBufferSize);
+    chunk->fill('a');
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        multipart::Parser::Ptr parser = multipart::Parser::create(boundary);
+        parser->write(head);
+        for (Size j = 0; j < 16; j++)
+            parser->write(chunk);
+        parser->write(tail);
+        bench::doNotOptimize(&*parser);
+    }
+}
+
+LIBNODE_MICRO_BENCH(Buffer, WriteUInt8) {
+    Buffer::Ptr buf = Buffer::create(kBufferSize);
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++)
+        buf->writeUInt8(static_cast<UByte>(i), i % kBufferSize);
+}
+
+LIBNODE_MICRO_BENCH(Buffer, ReadUInt8) {
+    Buffer::Ptr buf = Buffer::create(kBufferSize);
+    UByte v = 0;
+    UByte sum = 0;
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        buf->readUInt8(&v, i % kBufferSize);
+        sum += v;
+    }
+    bench::doNotOptimize(&sum);
+}
+
+LIBNODE_MICRO_BENCH(Buffer, WriteUInt32BE) {
+    Buffer::Ptr buf = Buffer::create(kBufferSize);
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++)
+        buf->writeUInt32BE(static_cast<UInt>(i), (i * 4) % kBufferSize);
+}
+
+LIBNODE_MICRO_BENCH(Buffer, ReadUInt32LE) {
+    Buffer::Ptr buf = Buffer::create(kBufferSize);
+    UInt v = 0;
+    UInt sum = 0;
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        buf->readUInt32LE(&v, (i * 4) % kBufferSize);
+        sum += v;
+    }
+    bench::doNotOptimize(&sum);
+}
+
+LIBNODE_MICRO_BENCH(Buffer, WriterRecord) {
+    BufferWriter writer(kBufferSize);
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        if (writer.length() >= kBufferSize)
+            bench::doNotOptimize(&*writer.toBuffer());
+        writer.writeBE<UShort>(1);
+        writer.writeBE<UInt>(static_cast<UInt>(i));
+        writer.writeVarint(i);
+    }
+}
+
+LIBNODE_MICRO_BENCH(Buffer, ReaderRecord) {
+    BufferWriter writer(kBufferSize);
+    while (writer.length() + 16 <= kBufferSize) {
+        writer.writeBE<UShort>(1);
+        writer.writeBE<UInt>(static_cast<UInt>(writer.length()));
+        writer.writeVarint(writer.length());
+    }
+    Buffer::Ptr buf = writer.toBuffer();
+    BufferReader reader(buf);
+    ULong sum = 0;
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        if (!reader.remaining())
+            reader = BufferReader(buf);
+        sum += reader.readBE<UShort>();
+        sum += reader.readBE<UInt>();
+        sum += reader.readVarint();
+    }
+    bench::doNotOptimize(&sum);
+}
+
+LIBNODE_MICRO_BENCH(Buffer, ReadDoubleBE) {
+    Buffer::Ptr buf = Buffer::create(kBufferSize);
+    Double v = 0;
+    Double sum = 0;
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        buf->readDoubleBE(&v, (i * 8) % kBufferSize);
+        sum += v;
+    }
+    bench::doNotOptimize(&sum);
+}
+
+}  // namespace node
+}  // namespace libj
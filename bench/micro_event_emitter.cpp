@@ -0,0 +1,108 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include "libnode/event_emitter.h"
+#include "./micro_bench.h"
+
+namespace libj {
+namespace node {
+namespace events {
+
+class Noop : LIBJ_JS_FUNCTION(Noop)
+ public:
+    Value operator()(JsArray::Ptr args) {
+        return 0;
+    }
+};
+
+static void emitWithListeners(size_t n, Size numListeners, bool byId) {
+    EventEmitter::Ptr ee = EventEmitter::create();
+    String::CPtr event = String::create("event");
+    for (Size i = 0; i < numListeners; i++) {
+        JsFunction::Ptr f(new Noop());
+        ee->on(event, f);
+    }
+    JsArray::Ptr args = JsArray::create();
+    args->add(1);
+
+    EventEmitter::EventId id = EventEmitter::intern(event);
+
+    bench::startTiming();
+    if (byId) {
+        for (size_t i = 0; i < n; i++)
+            ee->emit(id, args);
+    } else {
+        for (size_t i = 0; i < n; i++)
+            ee->emit(event, args);
+    }
+}
+
+LIBNODE_MICRO_BENCH(EventEmitter, Emit0Listeners) {
+    emitWithListeners(n, 0, false);
+}
+
+LIBNODE_MICRO_BENCH(EventEmitter, Emit1Listener) {
+    emitWithListeners(n, 1, false);
+}
+
+LIBNODE_MICRO_BENCH(EventEmitter, Emit8Listeners) {
+    emitWithListeners(n, 8, false);
+}
+
+LIBNODE_MICRO_BENCH(EventEmitter, EmitById0Listeners) {
+    emitWithListeners(n, 0, true);
+}
+
+LIBNODE_MICRO_BENCH(EventEmitter, EmitById1Listener) {
+    emitWithListeners(n, 1, true);
+}
+
+LIBNODE_MICRO_BENCH(EventEmitter, EmitById8Listeners) {
+    emitWithListeners(n, 8, true);
+}
+
+static void emitTyped(size_t n, Size numListeners) {
+    EventEmitter::Ptr ee = EventEmitter::create();
+    EventEmitter::EventId id = EventEmitter::intern(String::create("event"));
+    for (Size i = 0; i < numListeners; i++) {
+        JsFunction::Ptr f(new Noop());
+        ee->on(id, f);
+    }
+    String::CPtr chunk = String::create("chunk");
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++)
+        ee->emit(id, chunk);
+}
+
+LIBNODE_MICRO_BENCH(EventEmitter, EmitTyped0Listeners) {
+    emitTyped(n, 0);
+}
+
+LIBNODE_MICRO_BENCH(EventEmitter, EmitTyped1Listener) {
+    emitTyped(n, 1);
+}
+
+LIBNODE_MICRO_BENCH(EventEmitter, EmitWithNewArgs) {
+    EventEmitter::Ptr ee = EventEmitter::create();
+    String::CPtr event = String::create("event");
+    JsFunction::Ptr f(new Noop());
+    ee->on(event, f);
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        JsArray::Ptr args = JsArray::create();
+        args->add(1);
+        ee->emit(event, args);
+    }
+}
+
+LIBNODE_MICRO_BENCH(EventEmitter, Create) {
+    for (size_t i = 0; i < n; i++) {
+        EventEmitter::Ptr ee = EventEmitter::create();
+        bench::doNotOptimize(&*ee);
+    }
+}
+
+}  // namespace events
+}  // namespace node
+}  // namespace libj
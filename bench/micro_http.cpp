@@ -0,0 +1,220 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <http_parser.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "libnode/http_status.h"
+#include "libnode/node.h"
+#include "src/http_server_context.h"
+#include "./micro_bench.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+LIBNODE_MICRO_BENCH(HttpStatus, Create) {
+    static const Int codes[] = { 200, 304, 404, 500 };
+    for (size_t i = 0; i < n; i++) {
+        Status::CPtr s = Status::create(codes[i & 3]);
+        bench::doNotOptimize(&*s);
+    }
+}
+
+LIBNODE_MICRO_BENCH(HttpStatus, CreateWithMessage) {
+    String::CPtr msg = String::create("Custom");
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        Status::CPtr s = Status::create(599, msg);
+        bench::doNotOptimize(&*s);
+    }
+}
+
+static std::string makeRequest(Size numHeaders) {
+    std::string r = "GET /api/v1/search?q=libnode HTTP/1.1\r\n"
+                    "Host: localhost:10000\r\n";
+    for (Size i = 0; i < numHeaders; i++) {
+        char line[64];
+        snprintf(line, sizeof(line), "X-Header-%lu: value-%lu\r\n",
+            static_cast<unsigned long>(i), static_cast<unsigned long>(i));
+        r += line;
+    }
+    r += "\r\n";
+    return r;
+}
+
+// the callbacks mirror those of ServerImpl
+static String::CPtr headerName;
+
+static int onUrl(http_parser* parser, const char* at, size_t length) {
+    ServerContext* context = static_cast<ServerContext*>(parser->data);
+    context->request->setUrl(String::create(at, String::ASCII, length));
+    return 0;
+}
+
+static int onHeaderField(http_parser* parser, const char* at, size_t length) {
+    headerName = String::create(at, String::ASCII, length);
+    return 0;
+}
+
+static int onHeaderValue(http_parser* parser, const char* at, size_t length) {
+    ServerContext* context = static_cast<ServerContext*>(parser->data);
+    context->request->setHeader(
+        headerName,
+        String::create(at, String::ASCII, length));
+    return 0;
+}
+
+// a context owns a socket whose uv handle holds a reference on the loop
+// until it is closed, so contexts are only ever closed, which deletes
+// them once the loop has run the close callbacks. otherwise the loop is
+// kept alive, and the benches which run it never return.
+static void closeContexts(std::vector<ServerContext*>* contexts) {
+    for (Size i = 0; i < contexts->size(); i++)
+        (*contexts)[i]->close();
+    contexts->clear();
+    node::run();
+}
+
+static void parseHeaders(size_t n, Size numHeaders, bool callbacks) {
+    std::string req = makeRequest(numHeaders);
+    http_parser_settings settings;
+    memset(&settings, 0, sizeof(settings));
+    if (callbacks) {
+        settings.on_url = onUrl;
+        settings.on_header_field = onHeaderField;
+        settings.on_header_value = onHeaderValue;
+    }
+    std::vector<ServerContext*> contexts(1, new ServerContext(0));
+    ServerContext* context = contexts[0];
+    http_parser* parser = &context->parser;
+    parser->data = context;
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        context->request =
+            ServerRequestImpl::Ptr(new ServerRequestImpl(context));
+        http_parser_init(parser, HTTP_REQUEST);
+        http_parser_execute(parser, &settings, req.data(), req.length());
+    }
+    closeContexts(&contexts);
+}
+
+LIBNODE_MICRO_BENCH(HttpParser, Raw8Headers) {
+    parseHeaders(n, 8, false);
+}
+
+LIBNODE_MICRO_BENCH(HttpParser, Callbacks2Headers) {
+    parseHeaders(n, 2, true);
+}
+
+LIBNODE_MICRO_BENCH(HttpParser, Callbacks8Headers) {
+    parseHeaders(n, 8, true);
+}
+
+LIBNODE_MICRO_BENCH(HttpParser, Callbacks32Headers) {
+    parseHeaders(n, 32, true);
+}
+
+static void serializeResponse(size_t n, Size numHeaders, Size bodySize) {
+    std::vector<ServerContext*> contexts(1, new ServerContext(0));
+    std::vector<String::CPtr> names;
+    std::vector<String::CPtr> values;
+    for (Size i = 0; i < numHeaders; i++) {
+        names.push_back(String::create("X-Header-")
+            ->concat(String::valueOf(static_cast<Int>(i))));
+        values.push_back(String::create("value"));
+    }
+    String::CPtr body = String::create(std::string(bodySize, 'x').c_str());
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        ServerResponseImpl::Ptr res(new ServerResponseImpl(contexts[0]));
+        for (Size j = 0; j < numHeaders; j++)
+            res->setHeader(names[j], values[j]);
+        if (bodySize)
+            res->write(body);
+        res->makeResponse();
+        res->makeResBuf();
+    }
+    closeContexts(&contexts);
+}
+
+LIBNODE_MICRO_BENCH(HttpResponse, Headers2Body0) {
+    serializeResponse(n, 2, 0);
+}
+
+LIBNODE_MICRO_BENCH(HttpResponse, Headers8Body0) {
+    serializeResponse(n, 8, 0);
+}
+
+LIBNODE_MICRO_BENCH(HttpResponse, Headers32Body0) {
+    serializeResponse(n, 32, 0);
+}
+
+LIBNODE_MICRO_BENCH(HttpResponse, Headers8Body1K) {
+    serializeResponse(n, 8, 1024);
+}
+
+LIBNODE_MICRO_BENCH(HttpResponse, Headers8Body16K) {
+    serializeResponse(n, 8, 16 * 1024);
+}
+
+// contexts are closed in batches, as a server closes its connections,
+// so that few are alive at a time
+static const Size kBatchSize = 1024;
+
+// per-connection memory: bytes/op is the footprint of one connection,
+// its socket and uv handle included (malloc headers not included). the
+// target for an idle keep-alive connection is 1 KiB, i.e. about 200 MB
+// of fixed overhead at 200k concurrent connections.
+LIBNODE_MICRO_BENCH(HttpConnection, Idle) {
+    bench::setBytesTarget(1024);
+    std::vector<ServerContext*> contexts;
+    contexts.reserve(kBatchSize);
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        ServerContext* context = new ServerContext(0);
+        bench::doNotOptimize(context);
+        contexts.push_back(context);
+        if (contexts.size() == kBatchSize)
+            closeContexts(&contexts);
+    }
+    closeContexts(&contexts);
+}
+
+LIBNODE_MICRO_BENCH(HttpConnection, WithRequest) {
+    String::CPtr method = String::create("GET");
+    String::CPtr url = String::create("/index.html");
+    String::CPtr version = String::create("1.1");
+    String::CPtr host = String::create("Host");
+    String::CPtr hostValue = String::create("localhost");
+    std::vector<ServerContext*> contexts;
+    contexts.reserve(kBatchSize);
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        ServerContext* context = new ServerContext(0);
+        context->request =
+            ServerRequestImpl::Ptr(new ServerRequestImpl(context));
+        context->response =
+            ServerResponseImpl::Ptr(new ServerResponseImpl(context));
+        context->request->setMethod(method);
+        context->request->setUrl(url);
+        context->request->setHttpVersion(version);
+        context->request->setHeader(host, hostValue);
+        bench::doNotOptimize(context);
+        contexts.push_back(context);
+        if (contexts.size() == kBatchSize)
+            closeContexts(&contexts);
+    }
+    closeContexts(&contexts);
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,179 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+// usage: libnode-microbench [FILTER [MIN_SECONDS]]
+//
+// runs every micro benchmark whose name contains FILTER and reports
+// ns/op, allocations/op and allocated bytes/op, and whether the
+// benchmarks with a target for bytes/op meet it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "./micro_bench.h"
+
+#ifdef __GLIBC__
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void __libc_free(void* p);
+
+}
+#endif
+
+namespace libj {
+namespace node {
+namespace bench {
+
+static uint64_t numAllocs = 0;
+static uint64_t numBytes = 0;
+
+static const void* volatile sink = 0;
+
+static uint64_t startNs = 0;
+static uint64_t startAllocs = 0;
+static uint64_t startBytes = 0;
+
+static uint64_t bytesTarget = 0;
+
+static std::vector<MicroBench*>& registry() {
+    static std::vector<MicroBench*> benches;
+    return benches;
+}
+
+MicroBench::MicroBench(const char* name) : name_(name) {
+    registry().push_back(this);
+}
+
+static uint64_t now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+void startTiming() {
+    startAllocs = numAllocs;
+    startBytes = numBytes;
+    startNs = now();
+}
+
+uint64_t allocationCount() {
+    return numAllocs;
+}
+
+uint64_t allocationBytes() {
+    return numBytes;
+}
+
+void setBytesTarget(uint64_t bytes) {
+    bytesTarget = bytes;
+}
+
+void doNotOptimize(const void* p) {
+    sink = p;
+}
+
+struct Result {
+    size_t iterations;
+    uint64_t ns;
+    uint64_t allocs;
+    uint64_t bytes;
+};
+
+static Result measure(MicroBench* bench, size_t n) {
+    startTiming();
+    bench->run(n);
+    Result r;
+    r.ns = now() - startNs;
+    r.allocs = numAllocs - startAllocs;
+    r.bytes = numBytes - startBytes;
+    r.iterations = n;
+    return r;
+}
+
+static Result runBench(MicroBench* bench, double minSeconds) {
+    uint64_t minNs = static_cast<uint64_t>(minSeconds * 1e9);
+    size_t n = 1;
+    Result r = measure(bench, n);
+    while (r.ns < minNs && n < (1UL << 30)) {
+        double scale = r.ns ? 1.4 * minNs / r.ns : 100;
+        if (scale > 100) scale = 100;
+        if (scale < 2) scale = 2;
+        n = static_cast<size_t>(n * scale);
+        r = measure(bench, n);
+    }
+    return r;
+}
+
+}  // namespace bench
+}  // namespace node
+}  // namespace libj
+
+#ifdef __GLIBC__
+extern "C" {
+
+void* malloc(size_t size) {
+    libj::node::bench::numAllocs++;
+    libj::node::bench::numBytes += size;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+    libj::node::bench::numAllocs++;
+    libj::node::bench::numBytes += n * size;
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* p, size_t size) {
+    libj::node::bench::numAllocs++;
+    libj::node::bench::numBytes += size;
+    return __libc_realloc(p, size);
+}
+
+void free(void* p) {
+    __libc_free(p);
+}
+
+}
+#endif
+
+int main(int argc, char** argv) {
+    namespace bench = libj::node::bench;
+
+    const char* filter = argc > 1 ? argv[1] : "";
+    double minSeconds = argc > 2 ? atof(argv[2]) : 0.5;
+
+    printf("%-44s %12s %12s %10s %10s\n",
+        "benchmark", "iterations", "ns/op", "allocs/op", "bytes/op");
+    int status = 0;
+    std::vector<bench::MicroBench*>& benches = bench::registry();
+    for (size_t i = 0; i < benches.size(); i++) {
+        bench::MicroBench* b = benches[i];
+        if (!strstr(b->name(), filter))
+            continue;
+        bench::bytesTarget = 0;
+        bench::Result r = bench::runBench(b, minSeconds);
+        double n = static_cast<double>(r.iterations);
+        printf("%-44s %12lu %12.1f %10.2f %10.1f",
+            b->name(),
+            static_cast<unsigned long>(r.iterations),
+            r.ns / n,
+            r.allocs / n,
+            r.bytes / n);
+        if (bench::bytesTarget) {
+            bool isMet = r.bytes / n <= bench::bytesTarget;
+            printf("  (target %lu: %s)",
+                static_cast<unsigned long>(bench::bytesTarget),
+                isMet ? "met" : "MISSED");
+            if (!isMet)
+                status = 1;
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+    return status;
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <vector>
+
+#include "libnode/node.h"
+#include "libnode/process.h"
+#include "libnode/timer.h"
+#include "src/tick_queue.h"
+#include "./micro_bench.h"
+
+namespace libj {
+namespace node {
+
+class Noop : LIBJ_JS_FUNCTION(Noop)
+ public:
+    Value operator()(JsArray::Ptr args) {
+        return 0;
+    }
+};
+
+// the timers are never run, so only setting and clearing is measured
+LIBNODE_MICRO_BENCH(Timer, SetClear) {
+    JsFunction::Ptr f(new Noop());
+    JsArray::Ptr args = JsArray::create();
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        Value id = setTimeout(f, 30000, args);
+        clearTimeout(id);
+    }
+}
+
+// a million outstanding timers over a few durations, as with
+// a timeout per request, cancelled in the order they were set
+LIBNODE_MICRO_BENCH(Timer, SetClearMillion) {
+    static const Int delays[] = { 1000, 5000, 30000, 120000 };
+    static const size_t NUM_TIMERS = 1000000;
+    JsFunction::Ptr f(new Noop());
+    JsArray::Ptr args = JsArray::create();
+    std::vector<Value> ids(NUM_TIMERS);
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < NUM_TIMERS; j++)
+            ids[j] = setTimeout(f, delays[j & 3], args);
+        for (size_t j = 0; j < NUM_TIMERS; j++)
+            clearTimeout(ids[j]);
+    }
+}
+
+// deferring through an immediate, as opposed to setTimeout(cb, 0)
+LIBNODE_MICRO_BENCH(Timer, SetImmediateRun) {
+    JsFunction::Ptr f(new Noop());
+    JsArray::Ptr args = JsArray::create();
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++)
+        setImmediate(f, args);
+    node::run();
+}
+
+LIBNODE_MICRO_BENCH(Timer, SetTimeoutRun) {
+    JsFunction::Ptr f(new Noop());
+    JsArray::Ptr args = JsArray::create();
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++)
+        setTimeout(f, 0, args);
+    node::run();
+}
+
+LIBNODE_MICRO_BENCH(Timer, RequestIdleCallbackRun) {
+    JsFunction::Ptr f(new Noop());
+    JsArray::Ptr args = JsArray::create();
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++)
+        requestIdleCallback(f, args, 0, static_cast<Int>(i & 3));
+    node::run();
+}
+
+LIBNODE_MICRO_BENCH(Process, NextTick) {
+    JsFunction::Ptr f(new Noop());
+    JsArray::Ptr args = JsArray::create();
+
+    bench::startTiming();
+    for (size_t i = 0; i < n; i++) {
+        process::nextTick(f, args);
+        process::runTickQueue();
+    }
+}
+
+}  // namespace node
+}  // namespace libj
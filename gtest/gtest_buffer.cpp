@@ -0,0 +1,280 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+#include <libnode/buffer.h>
+
+#include <string>
+
+namespace libj {
+namespace node {
+
+TEST(GTestBuffer, TestCreatePooled) {
+    Buffer::Ptr a = Buffer::create(10);
+    Buffer::Ptr b = Buffer::create(10);
+    ASSERT_EQ(a->length(), 10);
+    ASSERT_EQ(b->length(), 10);
+
+    // small Buffers share a slab, without overlapping
+    const UByte* pa = static_cast<const UByte*>(a->data());
+    const UByte* pb = static_cast<const UByte*>(b->data());
+    ASSERT_TRUE(pb >= pa + 10 && pb < pa + 8 * 1024);
+
+    ASSERT_TRUE(a->writeUInt32BE(0x01020304, 6));
+    ASSERT_FALSE(a->writeUInt32BE(0x01020304, 7));
+    UByte v = 0xff;
+    ASSERT_TRUE(b->readUInt8(&v, 0));
+    ASSERT_EQ(v, 0);
+    UInt n = 0;
+    ASSERT_TRUE(a->readUInt32LE(&n, 6));
+    ASSERT_EQ(n, 0x04030201);
+}
+
+TEST(GTestBuffer, TestSetPool) {
+    Buffer::setPool(0, 0);
+    Buffer::Ptr a = Buffer::create(10);
+    Buffer::Ptr b = Buffer::create(10);
+    const UByte* pa = static_cast<const UByte*>(a->data());
+    const UByte* pb = static_cast<const UByte*>(b->data());
+    ASSERT_FALSE(pb == pa + 16);
+
+    Buffer::setPool(8 * 1024, 4 * 1024);
+}
+
+TEST(GTestBuffer, TestSlice) {
+    Buffer::Ptr buf = Buffer::create(String::create("0123456789"));
+    Buffer::Ptr s = buf->slice(2, 5);
+    ASSERT_EQ(s->length(), 3);
+    UByte v = 0;
+    ASSERT_TRUE(s->readUInt8(&v, 0));
+    ASSERT_EQ(v, '2');
+
+    // the slice shares the memory of the Buffer
+    ASSERT_TRUE(s->writeUInt8('x', 1));
+    ASSERT_TRUE(buf->readUInt8(&v, 3));
+    ASSERT_EQ(v, 'x');
+
+    ASSERT_EQ(buf->slice(8)->length(), 2);
+    ASSERT_EQ(buf->slice(20, 30)->length(), 0);
+    ASSERT_EQ(s->slice(1, 2)->data(), buf->slice(3, 4)->data());
+}
+
+TEST(GTestBuffer, TestConcat) {
+    JsArray::Ptr list = JsArray::create();
+    list->add(Buffer::create(String::create("abc")));
+    list->add(String::create("skipped"));
+    list->add(Buffer::create(String::create("de")));
+
+    Buffer::Ptr buf = Buffer::concat(list);
+    ASSERT_EQ(buf->length(), 5);
+    UByte v = 0;
+    ASSERT_TRUE(buf->readUInt8(&v, 3));
+    ASSERT_EQ(v, 'd');
+
+    ASSERT_EQ(Buffer::concat(list, 2)->length(), 2);
+    buf = Buffer::concat(list, 7);
+    ASSERT_TRUE(buf->readUInt8(&v, 6));
+    ASSERT_EQ(v, 0);
+}
+
+TEST(GTestBuffer, TestCopy) {
+    Buffer::Ptr src = Buffer::create(String::create("abcdef"));
+    Buffer::Ptr dst = Buffer::create(4);
+    ASSERT_EQ(src->copy(dst, 1, 2), 3);
+    UByte v = 0;
+    ASSERT_TRUE(dst->readUInt8(&v, 1));
+    ASSERT_EQ(v, 'c');
+    ASSERT_TRUE(dst->readUInt8(&v, 3));
+    ASSERT_EQ(v, 'e');
+
+    // overlapping ranges of the same memory
+    ASSERT_EQ(src->copy(src, 1, 0, 3), 3);
+    ASSERT_TRUE(src->readUInt8(&v, 3));
+    ASSERT_EQ(v, 'c');
+}
+
+TEST(GTestBuffer, TestBase64) {
+    String::CPtr str = String::create("libnode?>");
+    Buffer::Ptr buf = Buffer::create(str);
+    String::CPtr s = buf->toString(Buffer::BASE64);
+    ASSERT_EQ(s->compareTo(String::create("bGlibm9kZT8+")), 0);
+    s = buf->toString(Buffer::BASE64URL);
+    ASSERT_EQ(s->compareTo(String::create("bGlibm9kZT8-")), 0);
+    s = buf->toString(Buffer::BASE64, 0, 4);
+    ASSERT_EQ(s->compareTo(String::create("bGlibg==")), 0);
+
+    // either alphabet is accepted, and whitespace is skipped
+    Buffer::Ptr b = Buffer::create(
+        String::create("bGli bm9k\nZT8-"), Buffer::BASE64);
+    ASSERT_EQ(b->toString()->compareTo(str), 0);
+    b = Buffer::create(String::create("bGlibg=="), Buffer::BASE64URL);
+    ASSERT_EQ(b->toString()->compareTo(String::create("libn")), 0);
+}
+
+TEST(GTestBuffer, TestHex) {
+    Buffer::Ptr buf = Buffer::create(String::create("\x01\x7f"));
+    String::CPtr s = buf->toString(Buffer::HEX);
+    ASSERT_EQ(s->compareTo(String::create("017f")), 0);
+
+    Buffer::Ptr b = Buffer::create(String::create("0aFFzz"), Buffer::HEX);
+    ASSERT_EQ(b->length(), 2);
+    UByte v = 0;
+    ASSERT_TRUE(b->readUInt8(&v, 1));
+    ASSERT_EQ(v, 0xff);
+
+    ASSERT_EQ(buf->write(String::create("4142"), Buffer::HEX), 2);
+    ASSERT_EQ(buf->toString()->compareTo(String::create("AB")), 0);
+}
+
+static Buffer::Ptr createPattern(Size len) {
+    Buffer::Ptr buf = Buffer::create(len);
+    for (Size i = 0; i < len; i++)
+        buf->writeUInt8(static_cast<UByte>(i * 37 + 11), i);
+    return buf;
+}
+
+// one byte at a time, to check the block kernels against
+static std::string toBase64(Buffer::CPtr buf, Boolean url) {
+    const char* alphabet = url
+        ? "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+        : "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string s;
+    UInt v = 0;
+    Size bits = 0;
+    for (Size i = 0; i < buf->length(); i++) {
+        UByte b = 0;
+        buf->readUInt8(&b, i);
+        v = (v << 8) | b;
+        bits += 8;
+        while (bits >= 6) {
+            bits -= 6;
+            s.push_back(alphabet[(v >> bits) & 0x3f]);
+        }
+    }
+    if (bits)
+        s.push_back(alphabet[(v << (6 - bits)) & 0x3f]);
+    while (!url && s.length() % 4)
+        s.push_back('=');
+    return s;
+}
+
+TEST(GTestBuffer, TestBase64Long) {
+    // longer than the blocks of the SIMD kernels, with every length of
+    // the tail they leave
+    for (Size len = 60; len < 200; len++) {
+        Buffer::Ptr buf = createPattern(len);
+        std::string s = toBase64(buf, false);
+        ASSERT_EQ(buf->toString(Buffer::BASE64)->toStdString(), s);
+        ASSERT_EQ(buf->toString(Buffer::BASE64URL)->toStdString(),
+            toBase64(buf, true));
+
+        // whitespace and the other alphabet in the middle of a block
+        std::string t = s;
+        t.insert(t.length() / 2, " \r\n");
+        for (Size i = 0; i < t.length(); i++) {
+            if (i % 3 && t[i] == '+') t[i] = '-';
+            if (i % 3 && t[i] == '/') t[i] = '_';
+        }
+        Buffer::Ptr b = Buffer::create(String::create(t.c_str()),
+            Buffer::BASE64);
+        ASSERT_TRUE(b->equals(buf));
+        b = Buffer::create(String::create(s.c_str()), Buffer::BASE64URL);
+        ASSERT_TRUE(b->equals(buf));
+    }
+}
+
+TEST(GTestBuffer, TestHexLong) {
+    static const char digits[] = "0123456789abcdef";
+    for (Size len = 60; len < 200; len++) {
+        Buffer::Ptr buf = createPattern(len);
+        std::string s;
+        for (Size i = 0; i < len; i++) {
+            UByte b = 0;
+            buf->readUInt8(&b, i);
+            s.push_back(digits[b >> 4]);
+            s.push_back(digits[b & 0x0f]);
+        }
+        ASSERT_EQ(buf->toString(Buffer::HEX)->toStdString(), s);
+        Buffer::Ptr b = Buffer::create(String::create(s.c_str()),
+            Buffer::HEX);
+        ASSERT_TRUE(b->equals(buf));
+    }
+}
+
+TEST(GTestBuffer, TestLatin1) {
+    String::CPtr str = String::create("caf\xc3\xa9");
+    Buffer::Ptr buf = Buffer::create(str, Buffer::LATIN1);
+    ASSERT_EQ(buf->length(), 4);
+    UByte v = 0;
+    ASSERT_TRUE(buf->readUInt8(&v, 3));
+    ASSERT_EQ(v, 0xe9);
+    ASSERT_EQ(buf->toString(Buffer::LATIN1)->compareTo(str), 0);
+    String::CPtr s = buf->toString(Buffer::ASCII);
+    ASSERT_EQ(s->compareTo(String::create("cafi")), 0);
+}
+
+TEST(GTestBuffer, TestInvalidUtf8) {
+    Buffer::Ptr buf = Buffer::create(String::create("a\xc3\xa9"));
+    ASSERT_TRUE(buf->isUtf8());
+    ASSERT_FALSE(buf->slice(0, 2)->isUtf8());
+
+    // each invalid byte is decoded to U+FFFD
+    String::CPtr s = buf->slice(0, 2)->toString(Buffer::UTF8);
+    ASSERT_EQ(s->compareTo(String::create("a\xef\xbf\xbd")), 0);
+    // so is each byte of an encoded surrogate
+    s = Buffer::create(String::create("eda080"), Buffer::HEX)
+        ->toString(Buffer::UTF8);
+    ASSERT_EQ(s->length(), 3);
+}
+
+TEST(GTestBuffer, TestIndexOf) {
+    Buffer::Ptr buf = Buffer::create(String::create("abcabcabc"));
+    ASSERT_EQ(buf->indexOf('b'), 1);
+    ASSERT_EQ(buf->indexOf('b', 2), 4);
+    ASSERT_EQ(buf->indexOf('x'), NO_POS);
+    ASSERT_EQ(buf->indexOf(String::create("cab")), 2);
+    ASSERT_EQ(buf->indexOf(String::create("cab"), 3), 5);
+    ASSERT_EQ(buf->indexOf(String::create("cabx")), NO_POS);
+    ASSERT_EQ(buf->indexOf(Buffer::create(String::create("bc")), 8), NO_POS);
+    ASSERT_TRUE(buf->includes(String::create("abc"), 6));
+    ASSERT_FALSE(buf->includes(String::create("abc"), 7));
+
+    ASSERT_EQ(buf->lastIndexOf('a'), 6);
+    ASSERT_EQ(buf->lastIndexOf('a', 5), 3);
+    ASSERT_EQ(buf->lastIndexOf(String::create("abc")), 6);
+    ASSERT_EQ(buf->lastIndexOf(String::create("abc"), 5), 3);
+    ASSERT_EQ(buf->lastIndexOf(String::create("abc"), 0), 0);
+
+    // long enough for the vectorized scan to find it
+    Buffer::Ptr big = Buffer::create(1000);
+    big->fill('-');
+    big->write(String::create("--\r\n"), 900);
+    ASSERT_EQ(big->indexOf(String::create("-\r\n")), 901);
+    ASSERT_EQ(big->lastIndexOf(String::create("--")), 998);
+    ASSERT_EQ(big->lastIndexOf('\r'), 902);
+}
+
+TEST(GTestBuffer, TestCompare) {
+    Buffer::Ptr abc = Buffer::create(String::create("abc"));
+    Buffer::Ptr abd = Buffer::create(String::create("abd"));
+    Buffer::Ptr ab = Buffer::create(String::create("ab"));
+    ASSERT_EQ(abc->compare(abd), -1);
+    ASSERT_EQ(abd->compare(abc), 1);
+    ASSERT_EQ(ab->compare(abc), -1);
+    ASSERT_EQ(abc->compare(abc->slice(0)), 0);
+    ASSERT_TRUE(abc->equals(Buffer::create(String::create("abc"))));
+    ASSERT_FALSE(abc->equals(ab));
+}
+
+TEST(GTestBuffer, TestFill) {
+    Buffer::Ptr buf = Buffer::create(7);
+    ASSERT_TRUE(buf->fill(String::create("ab"), 1));
+    ASSERT_EQ(buf->toString(Buffer::LATIN1, 1)->compareTo(
+        String::create("ababab")), 0);
+    ASSERT_TRUE(buf->fill('x', 0, 2));
+    ASSERT_EQ(buf->toString()->compareTo(String::create("xxbabab")), 0);
+    ASSERT_TRUE(buf->fill(buf->slice(2, 4)));
+    ASSERT_EQ(buf->toString()->compareTo(String::create("bababab")), 0);
+}
+
+}  // namespace node
+}  // namespace libj
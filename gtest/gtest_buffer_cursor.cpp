@@ -0,0 +1,95 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+#include <libnode/buffer_cursor.h>
+
+namespace libj {
+namespace node {
+
+TEST(GTestBufferCursor, TestByteOrder) {
+    UByte bytes[4];
+    ByteOrder<UInt, false>::store(bytes, 0x01020304);
+    ASSERT_EQ(bytes[0], 0x01);
+    ASSERT_EQ(bytes[3], 0x04);
+    ASSERT_EQ((ByteOrder<UInt, true>::load(bytes)), 0x04030201);
+    ASSERT_EQ((ByteOrder<UShort, false>::load(bytes + 1)), 0x0203);
+}
+
+TEST(GTestBufferCursor, TestWriteRead) {
+    BufferWriter writer(4);
+    writer.writeUInt8(7);
+    writer.writeBE<UShort>(0x0102);
+    writer.writeLE<Int>(-2);
+    writer.writeBE<Double>(1.5);
+    writer.writeVarint(300);
+    writer.writeSignedVarint(-3);
+    writer.writeString(String::create("libnode"));
+    writer.writeBuffer(Buffer::create(String::create("xy")));
+
+    Buffer::Ptr buf = writer.toBuffer();
+    ASSERT_EQ(buf->length(), 1 + 2 + 4 + 8 + 2 + 1 + 8 + 3);
+    ASSERT_EQ(writer.length(), 0);
+    UShort v = 0;
+    ASSERT_TRUE(buf->readUInt16BE(&v, 1));
+    ASSERT_EQ(v, 0x0102);
+
+    BufferReader reader(buf);
+    ASSERT_EQ(reader.readUInt8(), 7);
+    ASSERT_EQ(reader.readBE<UShort>(), 0x0102);
+    ASSERT_EQ(reader.readLE<Int>(), -2);
+    ASSERT_EQ(reader.readBE<Double>(), 1.5);
+    ASSERT_EQ(reader.readVarint(), 300);
+    ASSERT_EQ(reader.readSignedVarint(), -3);
+    ASSERT_EQ(reader.readString()->compareTo(String::create("libnode")), 0);
+    Buffer::Ptr xy = reader.readBuffer();
+    ASSERT_EQ(xy->toString()->compareTo(String::create("xy")), 0);
+    ASSERT_EQ(reader.remaining(), 0);
+    ASSERT_TRUE(reader.isValid());
+}
+
+TEST(GTestBufferCursor, TestReservedRecord) {
+    BufferWriter writer;
+    for (UInt i = 0; i < 100; i++) {
+        UByte* p = writer.reserve(6);
+        ByteOrder<UShort, false>::store(p, 1);
+        ByteOrder<UInt, false>::store(p + 2, i);
+        writer.advance(6);
+    }
+
+    BufferReader reader(writer.toBuffer());
+    UInt sum = 0;
+    while (const UByte* p = reader.read(6))
+        sum += ByteOrder<UInt, false>::load(p + 2);
+    ASSERT_EQ(sum, 4950);
+}
+
+TEST(GTestBufferCursor, TestReadPastEnd) {
+    BufferWriter writer;
+    writer.writeVarint(10);
+    writer.write("abc", 3);
+
+    // the string claims 10 bytes but has 3
+    BufferReader reader(writer.toBuffer());
+    ASSERT_FALSE(reader.readString());
+    ASSERT_FALSE(reader.isValid());
+    ASSERT_EQ(reader.readUInt8(), 0);
+    ASSERT_EQ(reader.remaining(), 0);
+
+    // a varint which never ends
+    writer.writeBE<UInt>(0xffffffff);
+    BufferReader r(writer.toBuffer());
+    ASSERT_EQ(r.readVarint(), 0);
+    ASSERT_FALSE(r.isValid());
+}
+
+TEST(GTestBufferCursor, TestWriteEmpty) {
+    BufferWriter writer;
+    writer.write(0, 0);
+    ASSERT_EQ(writer.length(), 0);
+    writer.write("abc", 3);
+    writer.write("", 0);
+    ASSERT_EQ(writer.length(), 3);
+}
+
+}  // namespace node
+}  // namespace libj
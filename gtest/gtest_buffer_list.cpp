@@ -0,0 +1,75 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+#include <libnode/buffer_list.h>
+
+namespace libj {
+namespace node {
+
+static BufferList* createList(BufferList* list) {
+    list->append(String::create("abc"));
+    list->append(Buffer::create(static_cast<Size>(0)));
+    list->append(String::create("de"));
+    list->append(String::create("fghij"));
+    return list;
+}
+
+TEST(GTestBufferList, TestAppend) {
+    BufferList list;
+    ASSERT_TRUE(list.isEmpty());
+    createList(&list);
+    ASSERT_EQ(list.length(), 10);
+    ASSERT_FALSE(list.isEmpty());
+    list.clear();
+    ASSERT_EQ(list.length(), 0);
+}
+
+TEST(GTestBufferList, TestPeekConsume) {
+    BufferList list;
+    createList(&list);
+    Buffer::Ptr buf = list.peek(2);
+    ASSERT_EQ(buf->toString(Buffer::UTF8)->compareTo(
+        String::create("ab")), 0);
+    ASSERT_EQ(list.length(), 10);
+
+    buf = list.consume(4);
+    ASSERT_EQ(buf->toString(Buffer::UTF8)->compareTo(
+        String::create("abcd")), 0);
+    ASSERT_EQ(list.length(), 6);
+
+    list.skip(2);
+    buf = list.consume(100);
+    ASSERT_EQ(buf->toString(Buffer::UTF8)->compareTo(
+        String::create("ghij")), 0);
+    ASSERT_TRUE(list.isEmpty());
+    ASSERT_EQ(list.consume(1)->length(), 0);
+}
+
+TEST(GTestBufferList, TestIndexOf) {
+    BufferList list;
+    createList(&list);
+    ASSERT_EQ(list.indexOf('e'), 4);
+    ASSERT_EQ(list.indexOf('a', 1), NO_POS);
+    ASSERT_EQ(list.indexOf(String::create("cdef")), 2);
+    ASSERT_EQ(list.indexOf(String::create("ij")), 8);
+    ASSERT_EQ(list.indexOf(String::create("ij"), 9), NO_POS);
+    ASSERT_EQ(list.indexOf(String::create("cdx")), NO_POS);
+    ASSERT_EQ(list.indexOf(Buffer::create(String::create("efg")), 3), 4);
+
+    list.skip(1);
+    ASSERT_EQ(list.indexOf(String::create("cd")), 1);
+}
+
+TEST(GTestBufferList, TestFlatten) {
+    BufferList list;
+    createList(&list);
+    list.skip(1);
+    Buffer::Ptr buf = list.flatten();
+    ASSERT_EQ(buf->toString(Buffer::UTF8)->compareTo(
+        String::create("bcdefghij")), 0);
+    ASSERT_EQ(list.flatten()->data(), buf->data());
+    ASSERT_EQ(list.length(), 9);
+}
+
+}  // namespace node
+}  // namespace libj
@@ -105,6 +105,195 @@ TEST(GTestEventEmitter, TestEmit) {
     ASSERT_TRUE(i0 != i1 && (i1 == 2 || i1 == 8));
 }
 
+TEST(GTestEventEmitter, TestIntern) {
+    EventEmitter::EventId id = EventEmitter::intern(String::create("intern"));
+    ASSERT_EQ(id, EventEmitter::intern(String::create("intern")));
+    ASSERT_NE(id, EventEmitter::intern(String::create("intern2")));
+    ASSERT_EQ(EventEmitter::eventName(id)
+        ->compareTo(String::create("intern")), 0);
+}
+
+TEST(GTestEventEmitter, TestEmitById) {
+    EventEmitter::Ptr ee = EventEmitter::create();
+    EventEmitter::EventId id = EventEmitter::intern(String::create("byId"));
+    JsFunction::Ptr add = Add::create();
+    ee->on(String::create("byId"), add);
+
+    JsArray::Ptr args = JsArray::create();
+    args->add(7);
+    args->add(4);
+    Size n = results->size();
+    ee->emit(id, args);
+    ASSERT_EQ(results->size(), n + 1);
+
+    Int i;
+    to<Int>(results->get(n), &i);
+    ASSERT_EQ(i, 11);
+}
+
+TEST(GTestEventEmitter, TestRemoveListener) {
+    EventEmitter::Ptr ee = EventEmitter::create();
+    String::CPtr event = String::create("remove");
+    JsFunction::Ptr add = Add::create();
+    JsFunction::Ptr sub = Sub::create();
+    ee->on(event, add);
+    ee->on(event, sub);
+    ee->on(event, add);
+    ee->removeListener(event, add);
+
+    JsArray::Ptr a = toPtr<JsArray>(ee->listeners(event));
+    ASSERT_EQ(a->size(), 1);
+    ASSERT_TRUE(toPtr<JsFunction>(a->get(0)) == sub);
+
+    ee->removeAllListeners(event);
+    a = toPtr<JsArray>(ee->listeners(event));
+    ASSERT_EQ(a->size(), 0);
+}
+
+TEST(GTestEventEmitter, TestListenerCount) {
+    EventEmitter::Ptr ee = EventEmitter::create();
+    EventEmitter::EventId id = EventEmitter::intern(String::create("count"));
+    ASSERT_FALSE(ee->hasListeners(id));
+    ASSERT_EQ(ee->listenerCount(id), 0);
+
+    ee->on(id, Add::create());
+    ee->on(id, Sub::create());
+    ASSERT_TRUE(ee->hasListeners(id));
+    ASSERT_EQ(ee->listenerCount(id), 2);
+}
+
+TEST(GTestEventEmitter, TestTypedEmit) {
+    EventEmitter::Ptr ee = EventEmitter::create();
+    EventEmitter::EventId id = EventEmitter::intern(String::create("typed"));
+    ee->on(id, Sub::create());
+
+    Size n = results->size();
+    ee->emit(id, 9, 2);
+    ASSERT_EQ(results->size(), n + 1);
+
+    Int i;
+    to<Int>(results->get(n), &i);
+    ASSERT_EQ(i, 7);
+
+    // the listener rejects calls with the wrong number of arguments
+    ee->emit(id, 9);
+    ee->emit(id);
+    ASSERT_EQ(results->size(), n + 1);
+}
+
+TEST(GTestEventEmitter, TestPropertiesWithoutListeners) {
+    EventEmitter::Ptr ee = EventEmitter::create();
+    String::CPtr key = String::create("key");
+    ASSERT_FALSE(ee->containsKey(key));
+
+    ee->put(key, 5);
+    ASSERT_TRUE(ee->containsKey(key));
+    ASSERT_FALSE(ee->hasListeners(EventEmitter::intern(key)));
+}
+
+TEST(GTestEventEmitter, TestRemoveAllListenersKeepsProperties) {
+    EventEmitter::Ptr ee = EventEmitter::create();
+    String::CPtr key = String::create("key");
+    ee->put(key, 1);
+    ee->on(key, Add::create());
+    ee->removeAllListeners();
+    ASSERT_TRUE(ee->containsKey(key));
+}
+
+TEST(GTestEventEmitter, TestUnknownEventsAreNotInterned) {
+    EventEmitter::Ptr ee = EventEmitter::create();
+    EventEmitter::EventId id = EventEmitter::intern(String::create("known"));
+
+    String::CPtr unknown = String::create("unknown");
+    ee->emit(unknown, JsArray::create());
+    ee->removeListener(unknown, Add::create());
+    ee->removeAllListeners(unknown);
+    ASSERT_EQ(toPtr<JsArray>(ee->listeners(unknown))->size(), 0);
+
+    ASSERT_EQ(EventEmitter::intern(String::create("known2")), id + 1);
+}
+
+class RemoveSelf : LIBJ_JS_FUNCTION(RemoveSelf)
+ public:
+    explicit RemoveSelf(EventEmitter* ee) : ee_(ee) {}
+
+    Value operator()(JsArray::Ptr args) {
+        results->add(0);
+        ee_->removeListener(String::create("once"), self_);
+        return 0;
+    }
+
+    void setSelf(JsFunction::CPtr self) {
+        self_ = self;
+    }
+
+ private:
+    EventEmitter* ee_;
+    JsFunction::CPtr self_;
+};
+
+TEST(GTestEventEmitter, TestRemoveListenerDuringEmit) {
+    EventEmitter::Ptr ee = EventEmitter::create();
+    RemoveSelf::Ptr once(new RemoveSelf(&*ee));
+    once->setSelf(once);
+    ee->on(String::create("once"), once);
+    ee->on(String::create("once"), Add::create());
+
+    JsArray::Ptr args = JsArray::create();
+    args->add(1);
+    args->add(2);
+    Size n = results->size();
+    ee->emit(String::create("once"), args);
+    ASSERT_EQ(results->size(), n + 2);
+    ASSERT_EQ(ee->listenerCount(EventEmitter::intern(
+        String::create("once"))), 1);
+
+    // the cycle between the listener and itself is broken by now
+    once->setSelf(LIBJ_NULL(JsFunction));
+}
+
+class ChangeAll : LIBJ_JS_FUNCTION(ChangeAll)
+ public:
+    ChangeAll(EventEmitter* ee, JsFunction::Ptr added)
+        : ee_(ee)
+        , added_(added) {}
+
+    Value operator()(JsArray::Ptr args) {
+        results->add(0);
+        ee_->removeAllListeners();
+        ee_->on(String::create("change"), added_);
+        return 0;
+    }
+
+ private:
+    EventEmitter* ee_;
+    JsFunction::Ptr added_;
+};
+
+TEST(GTestEventEmitter, TestChangeListenersDuringEmit) {
+    EventEmitter::Ptr ee = EventEmitter::create();
+    ee->on(String::create("change"),
+        JsFunction::Ptr(new ChangeAll(&*ee, Add::create())));
+    ee->on(String::create("change"), Sub::create());
+
+    // the listener removed is not called, nor the one added
+    JsArray::Ptr args = JsArray::create();
+    args->add(1);
+    args->add(2);
+    Size n = results->size();
+    ee->emit(String::create("change"), args);
+    ASSERT_EQ(results->size(), n + 1);
+    EventEmitter::EventId change =
+        EventEmitter::intern(String::create("change"));
+    ASSERT_EQ(ee->listenerCount(change), 1);
+
+    ee->emit(change, args);
+    ASSERT_EQ(results->size(), n + 2);
+    Int x = 0;
+    to<Int>(results->get(n + 1), &x);
+    ASSERT_EQ(x, 3);
+}
+
 }  // namespace events
 }  // namespace node
 }  // namespace libj
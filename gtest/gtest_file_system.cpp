@@ -0,0 +1,449 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+#include <libnode/file_system.h>
+#include <libnode/node.h>
+#include <libnode/timer.h>
+#include <dirent.h>
+#include <stdio.h>
+
+#include <string>
+
+#ifdef LIBNODE_USE_IO_URING
+# include "../src/fs_uring.h"
+#endif
+
+namespace libj {
+namespace node {
+namespace fs {
+
+static JsArray::Ptr results = JsArray::create();
+
+class OnRead : LIBJ_JS_FUNCTION(OnRead)
+ public:
+    Value operator()(JsArray::Ptr args) {
+        results->add(args);
+        return 0;
+    }
+};
+
+static String::CPtr writeTemp(const char* data, Size len) {
+    const char* path = "/tmp/libnode_gtest_file_system";
+    FILE* f = fopen(path, "wb");
+    fwrite(data, 1, len, f);
+    fclose(f);
+    return String::create(path);
+}
+
+TEST(GTestFileSystem, TestReadFileBuffer) {
+    static const char data[] = "abc\0def";
+    String::CPtr path = writeTemp(data, sizeof(data));
+    results->clear();
+    readFile(path, JsFunction::Ptr(new OnRead()));
+    run();
+
+    ASSERT_EQ(results->size(), 1);
+    JsArray::Ptr args = toPtr<JsArray>(results->get(0));
+    Int err = -1;
+    to<Int>(args->get(0), &err);
+    ASSERT_EQ(err, 0);
+
+    // binary content is kept past the NUL
+    Buffer::Ptr buf = toPtr<Buffer>(args->get(1));
+    ASSERT_EQ(buf->length(), sizeof(data));
+    UByte b = 0;
+    ASSERT_TRUE(buf->readUInt8(&b, 6));
+    ASSERT_EQ(b, 'f');
+}
+
+TEST(GTestFileSystem, TestReadFileString) {
+    String::CPtr path = writeTemp("hello", 5);
+    results->clear();
+    readFile(path, String::UTF8, JsFunction::Ptr(new OnRead()));
+    run();
+
+    ASSERT_EQ(results->size(), 1);
+    JsArray::Ptr args = toPtr<JsArray>(results->get(0));
+    String::CPtr content = toCPtr<String>(args->get(1));
+    ASSERT_EQ(content->compareTo(String::create("hello")), 0);
+}
+
+TEST(GTestFileSystem, TestReadFileError) {
+    results->clear();
+    readFile(
+        String::create("/tmp/libnode_gtest_no_such_file"),
+        JsFunction::Ptr(new OnRead()));
+    run();
+
+    ASSERT_EQ(results->size(), 1);
+    JsArray::Ptr args = toPtr<JsArray>(results->get(0));
+    Int err = 0;
+    to<Int>(args->get(0), &err);
+    ASSERT_NE(err, 0);
+    ASSERT_EQ(args->size(), 1);
+}
+
+class OnEvent : LIBJ_JS_FUNCTION(OnEvent)
+ public:
+    explicit OnEvent(Int tag) : tag_(tag) {}
+
+    Value operator()(JsArray::Ptr args) {
+        Buffer::CPtr chunk = toCPtr<Buffer>(args->get(0));
+        if (chunk) {
+            results->add(static_cast<Int>(chunk->length()));
+        } else {
+            results->add(tag_);
+        }
+        return 0;
+    }
+
+ private:
+    Int tag_;
+};
+
+TEST(GTestFileSystem, TestCreateReadStream) {
+    String::CPtr path = writeTemp("0123456789", 10);
+    JsObject::Ptr options = JsObject::create();
+    options->put(HIGH_WATER_MARK, 3);
+    options->put(START, 2);
+    options->put(END, 8);
+
+    results->clear();
+    ReadStream::Ptr stream = createReadStream(path, options);
+    stream->on(ReadStream::EVENT_DATA, JsFunction::Ptr(new OnEvent(0)));
+    stream->on(ReadStream::EVENT_END, JsFunction::Ptr(new OnEvent(-1)));
+    stream->on(ReadStream::EVENT_CLOSE, JsFunction::Ptr(new OnEvent(-2)));
+    run();
+
+    ASSERT_EQ(stream->bytesRead(), 7);
+    ASSERT_EQ(results->size(), 5);
+    Int n[5];
+    for (Size i = 0; i < 5; i++)
+        to<Int>(results->get(i), &n[i]);
+    ASSERT_EQ(n[0], 3);
+    ASSERT_EQ(n[1], 3);
+    ASSERT_EQ(n[2], 1);
+    ASSERT_EQ(n[3], -1);
+    ASSERT_EQ(n[4], -2);
+}
+
+// collects what is written, and returns false from write() while full
+class Sink : LIBNODE_STREAM_WRITABLE(Sink)
+ public:
+    static Ptr create() {
+        Ptr p(new Sink());
+        return p;
+    }
+
+    Boolean write(Object::CPtr chunk) {
+        Buffer::CPtr buf = toCPtr<Buffer>(chunk);
+        data_.append(static_cast<const char*>(buf->data()), buf->length());
+        return !isFull_;
+    }
+
+    void end() {
+        isEnded_ = true;
+    }
+
+    const std::string& data() const { return data_; }
+
+    Boolean isEnded() const { return isEnded_; }
+
+    void setFull(Boolean full) { isFull_ = full; }
+
+ private:
+    std::string data_;
+    Boolean isFull_;
+    Boolean isEnded_;
+    EventEmitter::Ptr ee_;
+
+    Sink()
+        : isFull_(false)
+        , isEnded_(false)
+        , ee_(EventEmitter::create()) {}
+
+ public:
+    LIBNODE_EVENT_EMITTER_IMPL(ee_);
+};
+
+static ReadStream::Ptr createSmallReadStream(String::CPtr path) {
+    JsObject::Ptr options = JsObject::create();
+    options->put(HIGH_WATER_MARK, 3);
+    ReadStream::Ptr stream = createReadStream(path, options);
+    stream->on(ReadStream::EVENT_DATA, JsFunction::Ptr(new OnEvent(0)));
+    stream->on(ReadStream::EVENT_CLOSE, JsFunction::Ptr(new OnEvent(-2)));
+    return stream;
+}
+
+TEST(GTestFileSystem, TestReadStreamPipe) {
+    String::CPtr path = writeTemp("0123456789", 10);
+    results->clear();
+    ReadStream::Ptr stream = createSmallReadStream(path);
+    Sink::Ptr sink = Sink::create();
+    stream->pipe(sink);
+    run();
+
+    ASSERT_EQ(sink->data(), "0123456789");
+    ASSERT_TRUE(sink->isEnded());
+    ASSERT_EQ(sink->listenerCount(Sink::EVENT_DRAIN), 0);
+    ASSERT_EQ(sink->listenerCount(Sink::EVENT_CLOSE), 0);
+}
+
+TEST(GTestFileSystem, TestReadStreamPipeDrain) {
+    String::CPtr path = writeTemp("0123456789", 10);
+    results->clear();
+    ReadStream::Ptr stream = createSmallReadStream(path);
+    Sink::Ptr sink = Sink::create();
+    sink->setFull(true);
+    stream->pipe(sink);
+
+    // the loop runs out of work once the source is paused
+    run();
+    ASSERT_TRUE(stream->isPaused());
+    ASSERT_EQ(sink->data(), "012");
+    ASSERT_FALSE(sink->isEnded());
+
+    sink->setFull(false);
+    sink->emit(Sink::EVENT_DRAIN);
+    run();
+    ASSERT_EQ(sink->data(), "0123456789");
+    ASSERT_TRUE(sink->isEnded());
+}
+
+TEST(GTestFileSystem, TestReadStreamPipeDestClose) {
+    String::CPtr path = writeTemp("0123456789", 10);
+    results->clear();
+    ReadStream::Ptr stream = createSmallReadStream(path);
+    Sink::Ptr sink = Sink::create();
+    sink->setFull(true);
+    stream->pipe(sink);
+    run();
+    ASSERT_EQ(sink->data(), "012");
+
+    // the source is destroyed when the destination goes away
+    sink->emit(Sink::EVENT_CLOSE);
+    run();
+    ASSERT_EQ(sink->data(), "012");
+    ASSERT_FALSE(sink->isEnded());
+    ASSERT_EQ(results->size(), 2);
+    Int n = 0;
+    to<Int>(results->get(1), &n);
+    ASSERT_EQ(n, -2);
+}
+
+class PauseOnData : LIBJ_JS_FUNCTION(PauseOnData)
+ public:
+    explicit PauseOnData(ReadStream* stream) : stream_(stream) {}
+
+    Value operator()(JsArray::Ptr args) {
+        stream_->pause();
+        return 0;
+    }
+
+ private:
+    ReadStream* stream_;
+};
+
+TEST(GTestFileSystem, TestReadStreamPauseResume) {
+    String::CPtr path = writeTemp("0123456789", 10);
+    results->clear();
+    ReadStream::Ptr stream = createSmallReadStream(path);
+    JsFunction::Ptr pause(new PauseOnData(&*stream));
+    stream->on(ReadStream::EVENT_DATA, pause);
+    run();
+    ASSERT_TRUE(stream->isPaused());
+    ASSERT_EQ(results->size(), 1);
+
+    stream->removeListener(ReadStream::EVENT_DATA, pause);
+    stream->resume();
+    run();
+    ASSERT_FALSE(stream->isPaused());
+    ASSERT_EQ(stream->bytesRead(), 10);
+
+    // 3 + 3 + 3 + 1 bytes, then 'close'
+    ASSERT_EQ(results->size(), 5);
+    Int n = 0;
+    to<Int>(results->get(4), &n);
+    ASSERT_EQ(n, -2);
+}
+
+static Size countOpenFiles() {
+    Size n = 0;
+    DIR* dir = opendir("/proc/self/fd");
+    if (!dir)
+        return 0;
+    while (readdir(dir))
+        n++;
+    closedir(dir);
+    return n;
+}
+
+TEST(GTestFileSystem, TestReadStreamDestroyBeforeOpen) {
+    String::CPtr path = writeTemp("0123456789", 10);
+    Size numFiles = countOpenFiles();
+    results->clear();
+    ReadStream::Ptr stream = createSmallReadStream(path);
+    stream->destroy();
+    run();
+
+    // no data is read, and the file opened after destroy() is closed
+    ASSERT_EQ(stream->bytesRead(), 0);
+    ASSERT_EQ(results->size(), 1);
+    Int n = 0;
+    to<Int>(results->get(0), &n);
+    ASSERT_EQ(n, -2);
+    ASSERT_EQ(countOpenFiles(), numFiles);
+}
+
+static String::CPtr readBack(String::CPtr path) {
+    results->clear();
+    readFile(path, String::UTF8, JsFunction::Ptr(new OnRead()));
+    run();
+    JsArray::Ptr args = toPtr<JsArray>(results->get(0));
+    return toCPtr<String>(args->get(1));
+}
+
+#ifdef LIBNODE_USE_IO_URING
+static void afterUringRead(void* data, int err, Buffer::Ptr buffer) {
+    JsArray::Ptr args = JsArray::create();
+    args->add(err);
+    if (buffer)
+        args->add(buffer);
+    results->add(args);
+}
+
+TEST(GTestFileSystem, TestReadFileUring) {
+    if (!uring::available())
+        return;
+
+    String::CPtr path = writeTemp("uring", 5);
+    results->clear();
+    ASSERT_TRUE(uring::readFile("/tmp/libnode_gtest_file_system",
+                                afterUringRead, 0));
+    run();
+    ASSERT_EQ(results->size(), 1);
+    JsArray::Ptr args = toPtr<JsArray>(results->get(0));
+    ASSERT_EQ(args->size(), 2);
+    Buffer::Ptr buf = toPtr<Buffer>(args->get(1));
+    ASSERT_EQ(buf->toString(Buffer::UTF8)->compareTo(
+        String::create("uring")), 0);
+
+    // files of unknown size are left to the thread pool
+    results->clear();
+    ASSERT_TRUE(uring::readFile("/proc/self/stat", afterUringRead, 0));
+    run();
+    ASSERT_EQ(results->size(), 1);
+    args = toPtr<JsArray>(results->get(0));
+    ASSERT_EQ(args->size(), 1);
+
+    // and fs::readFile goes through it, falling back where it must
+    ASSERT_EQ(readBack(path)->compareTo(String::create("uring")), 0);
+    ASSERT_GT(readBack(String::create("/proc/self/stat"))->length(), 0);
+}
+#endif
+
+TEST(GTestFileSystem, TestWriteFileAndAppendFile) {
+    String::CPtr path = String::create("/tmp/libnode_gtest_write_file");
+    results->clear();
+    writeFile(path, String::create("abc"), JsFunction::Ptr(new OnRead()));
+    run();
+    ASSERT_EQ(results->size(), 1);
+    ASSERT_EQ(readBack(path)->compareTo(String::create("abc")), 0);
+
+    results->clear();
+    appendFile(path, String::create("def"), JsFunction::Ptr(new OnRead()));
+    run();
+    ASSERT_EQ(results->size(), 1);
+    JsArray::Ptr args = toPtr<JsArray>(results->get(0));
+    Int err = -1;
+    to<Int>(args->get(0), &err);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(readBack(path)->compareTo(String::create("abcdef")), 0);
+}
+
+TEST(GTestFileSystem, TestCreateWriteStream) {
+    String::CPtr path = String::create("/tmp/libnode_gtest_write_stream");
+    JsObject::Ptr options = JsObject::create();
+    options->put(HIGH_WATER_MARK, 4);
+    options->put(SYNC, SYNC_END);
+
+    results->clear();
+    WriteStream::Ptr stream = createWriteStream(path, options);
+    stream->on(WriteStream::EVENT_FINISH, JsFunction::Ptr(new OnEvent(-1)));
+    stream->on(WriteStream::EVENT_CLOSE, JsFunction::Ptr(new OnEvent(-2)));
+    ASSERT_TRUE(stream->write(String::create("ab")));
+    ASSERT_FALSE(stream->write(String::create("cd")));
+    stream->end();
+    ASSERT_FALSE(stream->write(String::create("ef")));
+    run();
+
+    ASSERT_EQ(stream->bytesWritten(), 4);
+    ASSERT_EQ(results->size(), 2);
+    Int n[2];
+    for (Size i = 0; i < 2; i++)
+        to<Int>(results->get(i), &n[i]);
+    ASSERT_EQ(n[0], -1);
+    ASSERT_EQ(n[1], -2);
+    ASSERT_EQ(readBack(path)->compareTo(String::create("abcd")), 0);
+}
+
+TEST(GTestFileSystem, TestMmap) {
+    static const char data[] = "\x01\x02\x03\x04";
+    String::CPtr path = writeTemp(data, 4);
+    JsObject::Ptr options = JsObject::create();
+    options->put(ADVICE, ADVICE_SEQUENTIAL);
+    Buffer::CPtr buf = mmap(path, options);
+    ASSERT_TRUE(!!buf);
+    ASSERT_EQ(buf->length(), 4);
+
+    UInt n = 0;
+    ASSERT_TRUE(buf->readUInt32BE(&n, 0));
+    ASSERT_EQ(n, 0x01020304);
+    ASSERT_TRUE(buf->readUInt32LE(&n, 0));
+    ASSERT_EQ(n, 0x04030201);
+    ASSERT_FALSE(buf->readUInt32BE(&n, 1));
+
+    ASSERT_FALSE(mmap(String::create("/tmp/libnode_gtest_no_such_file")));
+}
+
+TEST(GTestFileSystem, TestReadCache) {
+    String::CPtr path = writeTemp("cached", 6);
+    setReadCacheSize(1024);
+
+    // the second read waits for the first
+    results->clear();
+    readFile(path, JsFunction::Ptr(new OnRead()));
+    readFile(path, String::UTF8, JsFunction::Ptr(new OnRead()));
+    run();
+    ASSERT_EQ(results->size(), 2);
+    JsArray::Ptr args = toPtr<JsArray>(results->get(1));
+    String::CPtr content = toCPtr<String>(args->get(1));
+    ASSERT_EQ(content->compareTo(String::create("cached")), 0);
+
+    // the cached Buffer is read-only
+    results->clear();
+    readFile(path, JsFunction::Ptr(new OnRead()));
+    run();
+    ASSERT_EQ(results->size(), 1);
+    args = toPtr<JsArray>(results->get(0));
+    Buffer::Ptr buf = toPtr<Buffer>(args->get(1));
+    ASSERT_EQ(buf->length(), 6);
+    ASSERT_FALSE(buf->writeUInt8('C', 0));
+
+    // rewriting the file drops it from the cache. the watcher does not
+    // keep the loop alive, so a timer gives it the time to see the change.
+    writeTemp("changed", 7);
+    setTimeout(JsFunction::Ptr(new OnRead()), 50, JsArray::create());
+    run();
+
+    // a read without a callback only loads the file
+    readFile(path, LIBJ_NULL(JsFunction));
+    run();
+    ASSERT_EQ(readBack(path)->compareTo(String::create("changed")), 0);
+
+    setReadCacheSize(0);
+}
+
+}  // namespace fs
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,233 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+#include <libnode/multipart.h>
+
+#include <string>
+
+namespace libj {
+namespace node {
+namespace multipart {
+
+static std::string events;
+
+// write() returns false while set, as if the sink were full
+static Boolean isSinkFull = false;
+
+class Sink : LIBNODE_STREAM_WRITABLE(Sink)
+ public:
+    static Ptr create() {
+        Ptr p(new Sink());
+        return p;
+    }
+
+    Boolean write(Object::CPtr chunk) {
+        Buffer::CPtr buf = toCPtr<Buffer>(chunk);
+        events += "<";
+        events += buf->toString(Buffer::UTF8)->toStdString();
+        events += ">";
+        return !isSinkFull;
+    }
+
+    void end() {
+        events += "<end>";
+    }
+
+ private:
+    EventEmitter::Ptr ee_;
+
+    Sink() : ee_(EventEmitter::create()) {}
+
+ public:
+    LIBNODE_EVENT_EMITTER_IMPL(ee_);
+};
+
+static Sink::Ptr lastSink = LIBJ_NULL(Sink);
+
+class OnPart : LIBJ_JS_FUNCTION(OnPart)
+ public:
+    explicit OnPart(Parser* parser = NULL) : parser_(parser) {}
+
+    Value operator()(JsArray::Ptr args) {
+        JsObject::CPtr headers = toCPtr<JsObject>(args->get(0));
+        String::CPtr name =
+            headers->getCPtr<String>(String::create("content-disposition"));
+        events += "[part:";
+        if (name)
+            events += name->toStdString();
+        events += "]";
+        if (parser_) {
+            lastSink = Sink::create();
+            parser_->pipe(lastSink);
+        }
+        return 0;
+    }
+
+ private:
+    Parser* parser_;
+};
+
+class OnEvent : LIBJ_JS_FUNCTION(OnEvent)
+ public:
+    explicit OnEvent(const char* tag) : tag_(tag) {}
+
+    Value operator()(JsArray::Ptr args) {
+        events += "[";
+        events += tag_;
+        if (args->size()) {
+            Buffer::CPtr buf = toCPtr<Buffer>(args->get(0));
+            Int err;
+            if (buf) {
+                events += ":";
+                events += buf->toString(Buffer::UTF8)->toStdString();
+            } else if (to<Int>(args->get(0), &err)) {
+                events += ":";
+                events += String::valueOf(err)->toStdString();
+            }
+        }
+        events += "]";
+        return 0;
+    }
+
+ private:
+    const char* tag_;
+};
+
+static Parser::Ptr createParser(Boolean pipe = false) {
+    Parser::Ptr parser = Parser::create(String::create("xYz"));
+    JsFunction::Ptr onPart(new OnPart(pipe ? &*parser : NULL));
+    parser->on(Parser::EVENT_PART, onPart);
+    parser->on(Parser::EVENT_DATA, JsFunction::Ptr(new OnEvent("data")));
+    parser->on(Parser::EVENT_PART_END, JsFunction::Ptr(new OnEvent("/")));
+    parser->on(Parser::EVENT_END, JsFunction::Ptr(new OnEvent("end")));
+    parser->on(Parser::EVENT_ERROR, JsFunction::Ptr(new OnEvent("error")));
+    return parser;
+}
+
+static Buffer::Ptr toBuffer(const std::string& s) {
+    String::CPtr str = String::create(s.data(), String::UTF8, s.length());
+    return Buffer::create(str);
+}
+
+static const std::string body(
+    "preamble\r\n"
+    "--xYz\r\n"
+    "Content-Disposition: form-data; name=\"a\"\r\n"
+    "\r\n"
+    "one\r\n"
+    "--xYz \r\n"
+    "\r\n"
+    "\r\n--xY\r\n"
+    "--xYz--\r\n"
+    "epilogue");
+
+TEST(GTestMultipart, TestCreate) {
+    ASSERT_TRUE(!!Parser::create(String::create("xYz")));
+    ASSERT_FALSE(Parser::create(String::create()));
+    ASSERT_FALSE(Parser::create(String::create("a\r\nb")));
+    std::string tooLong(71, 'a');
+    ASSERT_FALSE(Parser::create(String::create(tooLong.c_str())));
+}
+
+TEST(GTestMultipart, TestWrite) {
+    events.clear();
+    Parser::Ptr parser = createParser();
+    ASSERT_TRUE(parser->write(toBuffer(body)));
+    ASSERT_FALSE(parser->write(toBuffer("more")));
+    parser->end();
+    ASSERT_EQ(events,
+        "[part:form-data; name=\"a\"][data:one][/]"
+        "[part:][data:\r\n--xY][/][end]");
+}
+
+TEST(GTestMultipart, TestWriteInPieces) {
+    Size len = body.length();
+    for (Size i = 1; i < len; i++) {
+        events.clear();
+        Parser::Ptr parser = createParser();
+        for (Size j = 0; j < len; j += i)
+            parser->write(toBuffer(body.substr(j, i)));
+        parser->end();
+
+        // data split across chunks is emitted in more than one piece
+        std::string joined;
+        for (Size k = 0; k < events.length(); k++) {
+            if (!events.compare(k, 7, "][data:"))
+                k += 6;
+            else
+                joined.push_back(events[k]);
+        }
+        ASSERT_EQ(joined,
+            "[part:form-data; name=\"a\"][data:one][/]"
+            "[part:][data:\r\n--xY][/][end]");
+    }
+}
+
+TEST(GTestMultipart, TestPipe) {
+    events.clear();
+    Parser::Ptr parser = createParser(true);
+    parser->write(toBuffer(body.substr(0, 62)));
+    parser->write(toBuffer(body.substr(62)));
+    ASSERT_EQ(events,
+        "[part:form-data; name=\"a\"]<o><ne><end>[/]"
+        "[part:]<\r\n--xY><end>[/][end]");
+}
+
+TEST(GTestMultipart, TestPipeDrain) {
+    events.clear();
+    isSinkFull = true;
+    Parser::Ptr parser = createParser(true);
+    parser->on(Parser::EVENT_DRAIN, JsFunction::Ptr(new OnEvent("drain")));
+
+    // the sink of the first part is full
+    ASSERT_FALSE(parser->write(toBuffer(body.substr(0, 62))));
+    ASSERT_EQ(events, "[part:form-data; name=\"a\"]<o>");
+    ASSERT_EQ(lastSink->listenerCount(Sink::EVENT_DRAIN), 1);
+
+    isSinkFull = false;
+    lastSink->emit(Sink::EVENT_DRAIN);
+    ASSERT_EQ(lastSink->listenerCount(Sink::EVENT_DRAIN), 0);
+    ASSERT_EQ(events, "[part:form-data; name=\"a\"]<o>[drain]");
+
+    // a sink ended within the same write is not waited for
+    isSinkFull = true;
+    ASSERT_TRUE(parser->write(toBuffer(body.substr(62))));
+    ASSERT_EQ(lastSink->listenerCount(Sink::EVENT_DRAIN), 0);
+    ASSERT_EQ(events,
+        "[part:form-data; name=\"a\"]<o>[drain]<ne><end>[/]"
+        "[part:]<\r\n--xY><end>[/][end]");
+    isSinkFull = false;
+}
+
+TEST(GTestMultipart, TestError) {
+    events.clear();
+    Parser::Ptr parser = createParser();
+    parser->write(toBuffer("--xYz\r\nno colon\r\n\r\n"));
+    ASSERT_EQ(events, "[error:2]");
+
+    events.clear();
+    parser = createParser();
+    parser->write(toBuffer("--xYz\r\n\r\ncut"));
+    parser->end();
+    ASSERT_EQ(events, "[part:][data:cut][error:4]");
+
+    events.clear();
+    parser = createParser();
+    parser->write(toBuffer("--xYz\r\nA: " + std::string(20000, 'a')));
+    ASSERT_EQ(events, "[error:3]");
+}
+
+TEST(GTestMultipart, TestBoundaryOf) {
+    ASSERT_EQ(boundaryOf(String::create(
+        "multipart/form-data; boundary=abc"))->compareTo(
+        String::create("abc")), 0);
+    ASSERT_EQ(boundaryOf(String::create(
+        "multipart/form-data; charset; Boundary=\"a;b c\"; x=y"))
+        ->compareTo(String::create("a;b c")), 0);
+    ASSERT_FALSE(boundaryOf(String::create("text/plain; charset=utf-8")));
+    ASSERT_FALSE(boundaryOf(String::create("multipart/form-data")));
+}
+
+}  // namespace multipart
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,75 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+#include <libj/js_array.h>
+#include <libnode/querystring.h>
+#include <libnode/url.h>
+
+namespace libj {
+namespace node {
+
+TEST(GTestQueryString, TestParse) {
+    JsObject::Ptr obj = querystring::parse(
+        String::create("a=1&b=x+y%21&&c&a=2&d=%zz&e="));
+    ASSERT_EQ(obj->size(), 5);
+    ASSERT_EQ(obj->getCPtr<String>(String::create("b"))
+        ->compareTo(String::create("x y!")), 0);
+    ASSERT_EQ(obj->getCPtr<String>(String::create("c"))
+        ->compareTo(String::create("")), 0);
+    ASSERT_EQ(obj->getCPtr<String>(String::create("d"))
+        ->compareTo(String::create("%zz")), 0);
+    ASSERT_EQ(obj->getCPtr<String>(String::create("e"))
+        ->compareTo(String::create("")), 0);
+
+    JsArray::CPtr a = obj->getCPtr<JsArray>(String::create("a"));
+    ASSERT_TRUE(!!a);
+    ASSERT_EQ(a->size(), 2);
+    ASSERT_EQ(toCPtr<String>(a->get(1))->compareTo(String::create("2")), 0);
+}
+
+TEST(GTestQueryString, TestParseOptions) {
+    JsObject::Ptr obj = querystring::parse(
+        String::create("a:1;b:2;c:3"), ';', ':', 2);
+    ASSERT_EQ(obj->size(), 2);
+    ASSERT_EQ(obj->getCPtr<String>(String::create("b"))
+        ->compareTo(String::create("2")), 0);
+    ASSERT_FALSE(obj->containsKey(String::create("c")));
+}
+
+TEST(GTestQueryString, TestUnescape) {
+    ASSERT_EQ(querystring::unescape(String::create("%E3%81%82%41"))
+        ->compareTo(String::create("\xe3\x81\x82" "A")), 0);
+
+    // a lone byte of a multibyte character is not valid UTF-8
+    ASSERT_EQ(querystring::unescape(String::create("%E3"))
+        ->compareTo(String::create("\xef\xbf\xbd")), 0);
+}
+
+TEST(GTestQueryString, TestStringify) {
+    JsObject::Ptr obj = JsObject::create();
+    JsArray::Ptr a = JsArray::create();
+    a->add(String::create("x y"));
+    a->add(String::create("1/2"));
+    obj->put(String::create("k"), a);
+    String::CPtr s = querystring::stringify(obj);
+    ASSERT_EQ(s->compareTo(String::create("k=x%20y&k=1%2F2")), 0);
+
+    JsObject::Ptr back = querystring::parse(s);
+    JsArray::CPtr b = back->getCPtr<JsArray>(String::create("k"));
+    ASSERT_EQ(toCPtr<String>(b->get(1))->compareTo(String::create("1/2")), 0);
+}
+
+TEST(GTestQueryString, TestUrlParse) {
+    JsObject::Ptr u = url::parse(String::create("/s?q=libnode&n=2"), true);
+    ASSERT_EQ(u->getCPtr<String>(url::SEARCH)
+        ->compareTo(String::create("?q=libnode&n=2")), 0);
+    JsObject::CPtr query = u->getCPtr<JsObject>(url::QUERY);
+    ASSERT_EQ(query->getCPtr<String>(String::create("q"))
+        ->compareTo(String::create("libnode")), 0);
+
+    u = url::parse(String::create("/s"), true);
+    ASSERT_EQ(u->getCPtr<JsObject>(url::QUERY)->size(), 0);
+}
+
+}  // namespace node
+}  // namespace libj
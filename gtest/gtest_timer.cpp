@@ -0,0 +1,200 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <gtest/gtest.h>
+#include <libnode/node.h>
+#include <libnode/process.h>
+#include <libnode/timer.h>
+
+namespace libj {
+namespace node {
+
+static JsArray::Ptr fired = JsArray::create();
+
+static Int firedAt(Size i) {
+    Int n = 0;
+    to<Int>(fired->get(i), &n);
+    return n;
+}
+
+class Record : LIBJ_JS_FUNCTION(Record)
+ public:
+    explicit Record(Int n) : n_(n) {}
+
+    Value operator()(JsArray::Ptr args) {
+        fired->add(n_);
+        return 0;
+    }
+
+ private:
+    Int n_;
+};
+
+class ClearSelf : LIBJ_JS_FUNCTION(ClearSelf)
+ public:
+    ClearSelf() : count_(0) {}
+
+    void setId(Value id) {
+        id_ = id;
+    }
+
+    Value operator()(JsArray::Ptr args) {
+        if (++count_ == 3)
+            clearInterval(id_);
+        fired->add(-count_);
+        return 0;
+    }
+
+ private:
+    Value id_;
+    Int count_;
+};
+
+TEST(GTestTimer, TestSetTimeout) {
+    fired->clear();
+    JsFunction::Ptr r1(new Record(1));
+    JsFunction::Ptr r2(new Record(2));
+    JsFunction::Ptr r3(new Record(3));
+    setTimeout(r3, 30, JsArray::create());
+    setTimeout(r1, 10, JsArray::create());
+    setTimeout(r2, 10, JsArray::create());
+    run();
+
+    ASSERT_EQ(fired->size(), 3);
+    ASSERT_EQ(firedAt(0), 1);
+    ASSERT_EQ(firedAt(1), 2);
+    ASSERT_EQ(firedAt(2), 3);
+}
+
+TEST(GTestTimer, TestClearTimeout) {
+    fired->clear();
+    JsFunction::Ptr r1(new Record(1));
+    JsFunction::Ptr r2(new Record(2));
+    Value id1 = setTimeout(r1, 10, JsArray::create());
+    setTimeout(r2, 10, JsArray::create());
+    clearTimeout(id1);
+    // clearing twice, or clearing a stale id, does nothing
+    clearTimeout(id1);
+    run();
+
+    ASSERT_EQ(fired->size(), 1);
+    ASSERT_EQ(firedAt(0), 2);
+
+    Value id3 = setTimeout(r1, 10, JsArray::create());
+    clearTimeout(id1);
+    run();
+    ASSERT_EQ(fired->size(), 2);
+    clearTimeout(id3);
+}
+
+TEST(GTestTimer, TestClearIntervalFromCallback) {
+    fired->clear();
+    ClearSelf::Ptr f(new ClearSelf());
+    f->setId(setInterval(f, 5, JsArray::create()));
+    run();
+
+    ASSERT_EQ(fired->size(), 3);
+    ASSERT_EQ(firedAt(2), -3);
+}
+
+TEST(GTestTimer, TestUnrefTimer) {
+    fired->clear();
+    JsFunction::Ptr r1(new Record(1));
+    JsFunction::Ptr r2(new Record(2));
+    Value id1 = setTimeout(r1, 60000, JsArray::create());
+    Value id2 = setTimeout(r2, 10, JsArray::create());
+    unrefTimer(id1);
+    setTimerSlack(id2, 20);
+    run();
+
+    // the loop exits without waiting for the unrefed timer
+    ASSERT_EQ(fired->size(), 1);
+    ASSERT_EQ(firedAt(0), 2);
+
+    refTimer(id1);
+    unrefTimer(id1);
+    run();
+    ASSERT_EQ(fired->size(), 1);
+    clearTimeout(id1);
+}
+
+TEST(GTestTimer, TestSlackDoesNotDelayOtherTimers) {
+    fired->clear();
+    JsFunction::Ptr r1(new Record(1));
+    JsFunction::Ptr r2(new Record(2));
+    JsFunction::Ptr r3(new Record(3));
+    Value id1 = setTimeout(r1, 10, JsArray::create());
+    setTimeout(r2, 10, JsArray::create());
+    setTimeout(r3, 200, JsArray::create());
+    setTimerSlack(id1, 5000);
+    run();
+
+    // the second timer has no slack, and the first is due before it
+    ASSERT_EQ(fired->size(), 3);
+    ASSERT_EQ(firedAt(0), 1);
+    ASSERT_EQ(firedAt(1), 2);
+    ASSERT_EQ(firedAt(2), 3);
+}
+
+TEST(GTestTimer, TestRequestIdleCallback) {
+    fired->clear();
+    JsFunction::Ptr r1(new Record(1));
+    JsFunction::Ptr r2(new Record(2));
+    JsFunction::Ptr r3(new Record(3));
+    JsFunction::Ptr r4(new Record(4));
+    requestIdleCallback(r1, JsArray::create(), 0, 0);
+    requestIdleCallback(r2, JsArray::create(), 0, 0);
+    Value id = requestIdleCallback(r3, JsArray::create(), 1000, 0);
+    requestIdleCallback(r4, JsArray::create(), 0, 1);
+    cancelIdleCallback(id);
+    run();
+
+    ASSERT_EQ(fired->size(), 3);
+    ASSERT_EQ(firedAt(0), 4);
+    ASSERT_EQ(firedAt(1), 1);
+    ASSERT_EQ(firedAt(2), 2);
+}
+
+class Defer : LIBJ_JS_FUNCTION(Defer)
+ public:
+    Value operator()(JsArray::Ptr args) {
+        fired->add(10);
+        JsFunction::Ptr r1(new Record(1));
+        JsFunction::Ptr r2(new Record(2));
+        setImmediate(r2, JsArray::create());
+        process::nextTick(r1, JsArray::create());
+        return 0;
+    }
+};
+
+TEST(GTestTimer, TestSetImmediate) {
+    fired->clear();
+    JsFunction::Ptr r1(new Record(1));
+    JsFunction::Ptr r2(new Record(2));
+    JsFunction::Ptr r3(new Record(3));
+    setImmediate(r1, JsArray::create());
+    Value id = setImmediate(r2, JsArray::create());
+    setImmediate(r3, JsArray::create());
+    clearImmediate(id);
+    run();
+
+    ASSERT_EQ(fired->size(), 2);
+    ASSERT_EQ(firedAt(0), 1);
+    ASSERT_EQ(firedAt(1), 3);
+}
+
+TEST(GTestTimer, TestNextTick) {
+    fired->clear();
+    JsFunction::Ptr defer(new Defer());
+    setTimeout(defer, 1, JsArray::create());
+    run();
+
+    // the tick runs as soon as the timer callback returns,
+    // and the immediate on the next turn of the loop
+    ASSERT_EQ(fired->size(), 3);
+    ASSERT_EQ(firedAt(0), 10);
+    ASSERT_EQ(firedAt(1), 1);
+    ASSERT_EQ(firedAt(2), 2);
+}
+
+}  // namespace node
+}  // namespace libj
@@ -47,5 +47,70 @@ TEST(GTestUrl, TestParse2) {
         ->compareTo(String::create("/foo/bar?abc=123&pqr=xyz")), 0);
 }
 
+TEST(GTestUrl, TestParseOriginForm) {
+    String::CPtr urlStr = String::create("/foo/bar?abc=123");
+    JsObject::Ptr url = url::parse(urlStr);
+    ASSERT_EQ(url->getCPtr<String>(url::PATH), urlStr);
+    ASSERT_EQ(url->getCPtr<String>(url::PATHNAME)
+        ->compareTo(String::create("/foo/bar")), 0);
+    ASSERT_EQ(url->getCPtr<String>(url::QUERY)
+        ->compareTo(String::create("abc=123")), 0);
+    ASSERT_FALSE(url->containsKey(url::PROTOCOL));
+    ASSERT_FALSE(url->containsKey(url::HOST));
+    ASSERT_FALSE(url->containsKey(url::HASH));
+
+    url = url::parse(String::create("/"));
+    ASSERT_EQ(url->getCPtr<String>(url::PATHNAME)
+        ->compareTo(String::create("/")), 0);
+    ASSERT_FALSE(url->containsKey(url::QUERY));
+}
+
+TEST(GTestUrl, TestParseHost) {
+    JsObject::Ptr url = url::parse(String::create("HTTP://WWW.Gtest.com"));
+    ASSERT_EQ(url->getCPtr<String>(url::PROTOCOL)
+        ->compareTo(String::create("http")), 0);
+    ASSERT_EQ(url->getCPtr<String>(url::HOST)
+        ->compareTo(String::create("www.gtest.com")), 0);
+    ASSERT_EQ(url->getCPtr<String>(url::HOSTNAME)
+        ->compareTo(String::create("www.gtest.com")), 0);
+    ASSERT_EQ(url->getCPtr<String>(url::PATHNAME)
+        ->compareTo(String::create("/")), 0);
+    ASSERT_FALSE(url->containsKey(url::PORT));
+    ASSERT_FALSE(url->containsKey(url::AUTH));
+
+    url = url::parse(String::create("http://[::1]:8080?x#y"));
+    ASSERT_EQ(url->getCPtr<String>(url::HOST)
+        ->compareTo(String::create("[::1]:8080")), 0);
+    ASSERT_EQ(url->getCPtr<String>(url::HOSTNAME)
+        ->compareTo(String::create("::1")), 0);
+    ASSERT_EQ(url->getCPtr<String>(url::PORT)
+        ->compareTo(String::create("8080")), 0);
+    ASSERT_EQ(url->getCPtr<String>(url::PATH)
+        ->compareTo(String::create("/?x")), 0);
+    ASSERT_EQ(url->getCPtr<String>(url::HASH)
+        ->compareTo(String::create("#y")), 0);
+}
+
+TEST(GTestUrl, TestNormalizePath) {
+    String::CPtr path = String::create("/a/b%2F/c");
+    ASSERT_EQ(url::normalizePath(path), path);
+
+    ASSERT_EQ(url::normalizePath(String::create("/a//./b/../%7ec%2f"))
+        ->compareTo(String::create("/a/~c%2F")), 0);
+    ASSERT_EQ(url::normalizePath(String::create("/a/b/.."))
+        ->compareTo(String::create("/a/")), 0);
+    ASSERT_FALSE(url::normalizePath(String::create("/a/../..")));
+    ASSERT_FALSE(url::normalizePath(String::create("/%2e%2E/x")));
+    ASSERT_FALSE(url::normalizePath(String::create("/a%2")));
+}
+
+TEST(GTestUrl, TestToFilePath) {
+    String::CPtr root = String::create("/srv/www/");
+    ASSERT_EQ(url::toFilePath(root, String::create("/img/../a%20b.txt"))
+        ->compareTo(String::create("/srv/www/a b.txt")), 0);
+    ASSERT_FALSE(url::toFilePath(root, String::create("/..%2Fetc/passwd")));
+    ASSERT_FALSE(url::toFilePath(root, String::create("/a%00.txt")));
+}
+
 }  // namespace node
 }  // namespace libj
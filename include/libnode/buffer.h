@@ -3,6 +3,7 @@
 #ifndef LIBNODE_BUFFER_H_
 #define LIBNODE_BUFFER_H_
 
+#include <libj/js_array.h>
 #include <libj/js_array_buffer.h>
 #include <libj/js_typed_array.h>
 
@@ -11,16 +12,117 @@ namespace node {
 
 class Buffer : LIBJ_JS_ARRAY_BUFFER(Buffer)
  public:
+    // encodings between bytes and text, besides the Unicode ones of
+    // String. toString() decodes each byte to its low 7 bits with ASCII,
+    // and to the code point of its value with LATIN1, and both encode
+    // characters to their low 8 bits.
+    enum Encoding {
+        UTF8,
+        ASCII,
+        LATIN1,
+        HEX,
+        BASE64,
+        BASE64URL
+    };
+
     static Ptr create(Size length);
     static Ptr create(JsTypedArray<UByte>::CPtr array);
     static Ptr create(String::CPtr str, String::Encoding enc = String::UTF8);
 
+    // HEX stops at the first invalid pair of digits. BASE64 and BASE64URL
+    // both accept either alphabet, skip other characters, and stop at '='.
+    static Ptr create(String::CPtr str, Encoding enc);
+
+    // Buffers shorter than 'threshold' bytes are carved out of shared
+    // slabs of 'slabLength' bytes, each freed once none of its Buffers is
+    // left. the defaults are 8 KiB and 4 KiB, and 0 disables the pool.
+    // like the rest of libnode, the pool is used only on the loop thread.
+    static void setPool(Size slabLength, Size threshold);
+
+    // a Buffer of the Buffers in 'list' one after another, allocated and
+    // copied once. with 'totalLength', it is cut or zero-padded to it.
+    // elements which are not Buffers are skipped.
+    static Ptr concat(JsArray::CPtr list, Size totalLength = NO_POS);
+
+    // true for Buffers over memory which can't be written, such as mapped
+    // files, whose writes fail
+    virtual Boolean isReadOnly() const = 0;
+
+    // a Buffer over bytes 'start' to 'end' (exclusive) of this one,
+    // sharing its memory and keeping it alive
+    virtual Ptr slice(Size start, Size end = NO_POS) const = 0;
+
+    // copies bytes 'sourceStart' to 'sourceEnd' (exclusive) into 'target'
+    // at 'targetStart', as many as fit. the ranges may overlap. returns
+    // the number of bytes copied.
+    Size copy(
+        Ptr target,
+        Size targetStart = 0,
+        Size sourceStart = 0,
+        Size sourceEnd = NO_POS) const;
+
     virtual void write(
         String::CPtr str,
         Size offset = 0,
         Size length = NO_POS,
         String::Encoding enc = String::UTF8) = 0;
 
+    // writes 'str' decoded as with create() at 'offset', at most 'length'
+    // bytes, and returns the number of bytes written
+    Size write(
+        String::CPtr str,
+        Encoding enc,
+        Size offset = 0,
+        Size length = NO_POS);
+
+    using JsArrayBuffer::toString;
+
+    // bytes 'start' to 'end' (exclusive) as text. invalid UTF-8 sequences
+    // are decoded to U+FFFD.
+    String::CPtr toString(
+        Encoding enc,
+        Size start = 0,
+        Size end = NO_POS) const;
+
+    // true if the whole Buffer is valid UTF-8
+    Boolean isUtf8() const;
+
+    // the position of the first occurrence at or after 'byteOffset' of
+    // a byte, the UTF-8 bytes of a String or the bytes of a Buffer, or
+    // NO_POS
+    Size indexOf(UByte value, Size byteOffset = 0) const;
+    Size indexOf(String::CPtr value, Size byteOffset = 0) const;
+    Size indexOf(CPtr value, Size byteOffset = 0) const;
+
+    // the position of the last occurrence at or before 'byteOffset'
+    Size lastIndexOf(UByte value, Size byteOffset = NO_POS) const;
+    Size lastIndexOf(String::CPtr value, Size byteOffset = NO_POS) const;
+    Size lastIndexOf(CPtr value, Size byteOffset = NO_POS) const;
+
+    Boolean includes(UByte value, Size byteOffset = 0) const {
+        return indexOf(value, byteOffset) != NO_POS;
+    }
+
+    Boolean includes(String::CPtr value, Size byteOffset = 0) const {
+        return indexOf(value, byteOffset) != NO_POS;
+    }
+
+    Boolean includes(CPtr value, Size byteOffset = 0) const {
+        return indexOf(value, byteOffset) != NO_POS;
+    }
+
+    // -1, 0 or 1 as this Buffer sorts before, the same as or after
+    // 'target', byte by byte and then by length
+    Int compare(CPtr target) const;
+
+    Boolean equals(CPtr target) const;
+
+    // fills bytes 'start' to 'end' (exclusive) with 'value' repeated,
+    // or with zeros if it is empty. false if the Buffer is read-only.
+    Boolean fill(UByte value, Size start = 0, Size end = NO_POS);
+    Boolean fill(String::CPtr value, Size start = 0, Size end = NO_POS);
+    Boolean fill(CPtr value, Size start = 0, Size end = NO_POS);
+
 #ifdef LIBJ_USE_EXCEPTION
     UByte readUInt8(Size offset) const {
         return getUInt8(offset);
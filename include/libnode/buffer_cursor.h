@@ -0,0 +1,250 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_BUFFER_CURSOR_H_
+#define LIBNODE_BUFFER_CURSOR_H_
+
+#include <string.h>
+
+#include "libnode/buffer.h"
+
+namespace libj {
+namespace node {
+
+// unaligned loads and stores of integers and floats of 1, 2, 4 or 8 bytes
+// in either byte order, compiled down to a move and at most a byte swap
+
+template<Size N>
+struct ByteSwap;
+
+template<>
+struct ByteSwap<1> {
+    typedef UByte Bits;
+    static Bits swap(Bits v) { return v; }
+};
+
+template<>
+struct ByteSwap<2> {
+    typedef UShort Bits;
+    static Bits swap(Bits v) { return __builtin_bswap16(v); }
+};
+
+template<>
+struct ByteSwap<4> {
+    typedef UInt Bits;
+    static Bits swap(Bits v) { return __builtin_bswap32(v); }
+};
+
+template<>
+struct ByteSwap<8> {
+    typedef ULong Bits;
+    static Bits swap(Bits v) { return __builtin_bswap64(v); }
+};
+
+template<typename T, Boolean LittleEndian>
+struct ByteOrder {
+    typedef typename ByteSwap<sizeof(T)>::Bits Bits;
+
+    static T load(const UByte* p) {
+        Bits b;
+        memcpy(&b, p, sizeof(b));
+        if (LittleEndian != isHostLittleEndian())
+            b = ByteSwap<sizeof(T)>::swap(b);
+        T v;
+        memcpy(&v, &b, sizeof(v));
+        return v;
+    }
+
+    static void store(UByte* p, T v) {
+        Bits b;
+        memcpy(&b, &v, sizeof(b));
+        if (LittleEndian != isHostLittleEndian())
+            b = ByteSwap<sizeof(T)>::swap(b);
+        memcpy(p, &b, sizeof(b));
+    }
+
+    static Boolean isHostLittleEndian() {
+        return __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+    }
+};
+
+// writes records one after another into a Buffer which doubles as it
+// fills. a record of a known size can be stored with a single check:
+//
+//     UByte* p = writer.reserve(6);
+//     ByteOrder<UShort, false>::store(p, type);
+//     ByteOrder<UInt, false>::store(p + 2, id);
+//     writer.advance(6);
+class BufferWriter {
+ public:
+    explicit BufferWriter(Size capacity = 64);
+
+    Size length() const {
+        return length_;
+    }
+
+    // room for 'n' more bytes, which the caller stores at the returned
+    // address and then passes to advance()
+    UByte* reserve(Size n) {
+        if (n > capacity_ - length_)
+            grow(n);
+        return data_ + length_;
+    }
+
+    void advance(Size n) {
+        length_ += n;
+    }
+
+    void write(const void* data, Size len) {
+        // reserve(0) on a writer not grown yet returns null
+        if (!len)
+            return;
+        memcpy(reserve(len), data, len);
+        length_ += len;
+    }
+
+    void writeUInt8(UByte value) {
+        *reserve(1) = value;
+        length_++;
+    }
+
+    template<typename T>
+    void writeLE(T value) {
+        ByteOrder<T, true>::store(reserve(sizeof(T)), value);
+        length_ += sizeof(T);
+    }
+
+    template<typename T>
+    void writeBE(T value) {
+        ByteOrder<T, false>::store(reserve(sizeof(T)), value);
+        length_ += sizeof(T);
+    }
+
+    // LEB128, 7 bits a byte, least significant first
+    void writeVarint(ULong value) {
+        if (value < 0x80) {
+            writeUInt8(static_cast<UByte>(value));
+        } else {
+            writeLongVarint(value);
+        }
+    }
+
+    // zigzag, so that small negative values are short as well
+    void writeSignedVarint(Long value) {
+        writeVarint((static_cast<ULong>(value) << 1)
+            ^ static_cast<ULong>(value >> 63));
+    }
+
+    // the length as a varint, then the UTF-8 bytes
+    void writeString(String::CPtr str);
+
+    // the length as a varint, then the bytes
+    void writeBuffer(Buffer::CPtr buf);
+
+    // the bytes written so far. the writer starts over empty.
+    Buffer::Ptr toBuffer();
+
+ private:
+    BufferWriter(const BufferWriter&);
+    BufferWriter& operator=(const BufferWriter&);
+
+    void grow(Size n);
+    void writeLongVarint(ULong value);
+
+    Buffer::Ptr buffer_;
+    UByte* data_;
+    Size length_;
+    Size capacity_;
+    Size initialCapacity_;
+};
+
+// reads records one after another from a Buffer. a read past the end
+// fails, returning 0 or null, and so do all the reads after it, so that
+// a record can be read whole and isValid() checked once at its end.
+// a record of a known size can be taken with a single check:
+//
+//     const UByte* p = reader.read(6);
+//     if (!p) return;
+//     UShort type = ByteOrder<UShort, false>::load(p);
+//     UInt id = ByteOrder<UInt, false>::load(p + 2);
+class BufferReader {
+ public:
+    explicit BufferReader(Buffer::CPtr buf);
+
+    Boolean isValid() const {
+        return isValid_;
+    }
+
+    Size position() const {
+        return position_;
+    }
+
+    Size remaining() const {
+        return length_ - position_;
+    }
+
+    // the address of the next 'n' bytes, which are consumed, or null if
+    // fewer are left
+    const UByte* read(Size n) {
+        if (n > length_ - position_) {
+            fail();
+            return 0;
+        }
+        const UByte* p = data_ + position_;
+        position_ += n;
+        return p;
+    }
+
+    UByte readUInt8() {
+        const UByte* p = read(1);
+        return p ? *p : 0;
+    }
+
+    template<typename T>
+    T readLE() {
+        const UByte* p = read(sizeof(T));
+        return p ? ByteOrder<T, true>::load(p) : T();
+    }
+
+    template<typename T>
+    T readBE() {
+        const UByte* p = read(sizeof(T));
+        return p ? ByteOrder<T, false>::load(p) : T();
+    }
+
+    ULong readVarint() {
+        if (position_ < length_ && data_[position_] < 0x80)
+            return data_[position_++];
+        return readLongVarint();
+    }
+
+    Long readSignedVarint() {
+        ULong v = readVarint();
+        return static_cast<Long>(v >> 1) ^ -static_cast<Long>(v & 1);
+    }
+
+    // as written by BufferWriter::writeString()
+    String::CPtr readString();
+
+    // as written by BufferWriter::writeBuffer(), a slice sharing the
+    // memory of the Buffer read
+    Buffer::Ptr readBuffer();
+
+ private:
+    void fail() {
+        isValid_ = false;
+        position_ = length_;
+    }
+
+    ULong readLongVarint();
+
+    Buffer::CPtr buffer_;
+    const UByte* data_;
+    Size length_;
+    Size position_;
+    Boolean isValid_;
+};
+
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_BUFFER_CURSOR_H_
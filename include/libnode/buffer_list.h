@@ -0,0 +1,71 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_BUFFER_LIST_H_
+#define LIBNODE_BUFFER_LIST_H_
+
+#include <deque>
+
+#include "libnode/buffer.h"
+
+namespace libj {
+namespace node {
+
+// a chain of Buffers read from the front, for accumulating streamed data.
+// appended Buffers are kept as they are, not copied, and bytes are
+// copied only when a request spans more than one of them.
+class BufferList {
+ public:
+    BufferList();
+
+    Size length() const {
+        return length_;
+    }
+
+    Boolean isEmpty() const {
+        return !length_;
+    }
+
+    // empty Buffers are skipped. the Buffer must not be written to while
+    // it is in the list.
+    void append(Buffer::CPtr buf);
+
+    // the UTF-8 bytes of 'str'
+    void append(String::CPtr str);
+
+    void clear();
+
+    // the first 'n' bytes, or all of them if fewer, left in the list.
+    // a slice if they are all in the first Buffer, and a copy otherwise.
+    Buffer::Ptr peek(Size n) const;
+
+    // as peek(), but removes the bytes from the list
+    Buffer::Ptr consume(Size n);
+
+    // removes the first 'n' bytes, or all of them if fewer
+    void skip(Size n);
+
+    // the position of the first occurrence at or after 'byteOffset',
+    // including those across Buffers, or NO_POS
+    Size indexOf(UByte value, Size byteOffset = 0) const;
+    Size indexOf(String::CPtr value, Size byteOffset = 0) const;
+    Size indexOf(Buffer::CPtr value, Size byteOffset = 0) const;
+
+    // the whole list as a single Buffer, which then replaces the Buffers
+    // in the list, so that flattening again costs nothing
+    Buffer::Ptr flatten();
+
+ private:
+    Size indexOfBytes(const UByte* needle, Size n, Size byteOffset) const;
+    Boolean matchesAt(Size index, Size offset, const UByte* s, Size n) const;
+    void copyTo(UByte* dst, Size n) const;
+
+    // bytes 'head_' onwards of the first Buffer are in the list
+    std::deque<Buffer::CPtr> buffers_;
+    Size head_;
+    Size length_;
+};
+
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_BUFFER_LIST_H_
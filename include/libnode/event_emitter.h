@@ -14,8 +14,14 @@ namespace events {
 
 class EventEmitter : LIBJ_JS_OBJECT(EventEmitter)
  public:
+    // small integer id of an interned event name
+    typedef Size EventId;
+
     static Ptr create();
 
+    static EventId intern(String::CPtr event);
+    static String::CPtr eventName(EventId event);
+
     virtual void on(
         String::CPtr event, JsFunction::Ptr listener) = 0;
     virtual void addListener(
@@ -26,6 +32,37 @@ class EventEmitter : LIBJ_JS_OBJECT(EventEmitter)
     virtual void removeAllListeners(String::CPtr event) = 0;
     virtual void emit(String::CPtr event, JsArray::Ptr args) = 0;
     virtual Value listeners(String::CPtr event) = 0;
+
+    virtual void on(
+        EventId event, JsFunction::Ptr listener) = 0;
+    virtual void addListener(
+        EventId event, JsFunction::Ptr listener) = 0;
+    virtual void removeListener(
+        EventId event, JsFunction::CPtr listener) = 0;
+    virtual void removeAllListeners(EventId event) = 0;
+    virtual void emit(EventId event, JsArray::Ptr args) = 0;
+    virtual Value listeners(EventId event) = 0;
+
+    virtual Size listenerCount(EventId event) const = 0;
+
+    Boolean hasListeners(EventId event) const {
+        return listenerCount(event) != 0;
+    }
+
+    // emit without an arguments array of the caller's own.
+    // nothing is allocated when there are no listeners, and the array
+    // handed to listeners is reused, so it is only valid during the call.
+    // a single JsArray argument is taken by emit(EventId, JsArray::Ptr)
+    // as the whole argument list.
+    virtual void emit(EventId event) = 0;
+    virtual void emit(EventId event, const Value& arg0) = 0;
+    virtual void emit(
+        EventId event, const Value& arg0, const Value& arg1) = 0;
+    virtual void emit(
+        EventId event,
+        const Value& arg0,
+        const Value& arg1,
+        const Value& arg2) = 0;
 };
 
 #define LIBNODE_EVENT_EMITTER(T) \
@@ -55,6 +92,43 @@ public: \
     } \
     Value listeners(String::CPtr event) { \
         return EE->listeners(event); \
+    } \
+    void on(EventId event, JsFunction::Ptr listener) { \
+        EE->on(event, listener); \
+    } \
+    void addListener(EventId event, JsFunction::Ptr listener) { \
+        EE->addListener(event, listener); \
+    } \
+    void removeListener(EventId event, JsFunction::CPtr listener) { \
+        EE->removeListener(event, listener); \
+    } \
+    void removeAllListeners(EventId event) { \
+        EE->removeAllListeners(event); \
+    } \
+    void emit(EventId event, JsArray::Ptr args) { \
+        EE->emit(event, args); \
+    } \
+    Value listeners(EventId event) { \
+        return EE->listeners(event); \
+    } \
+    Size listenerCount(EventId event) const { \
+        return EE->listenerCount(event); \
+    } \
+    void emit(EventId event) { \
+        EE->emit(event); \
+    } \
+    void emit(EventId event, const Value& arg0) { \
+        EE->emit(event, arg0); \
+    } \
+    void emit(EventId event, const Value& arg0, const Value& arg1) { \
+        EE->emit(event, arg0, arg1); \
+    } \
+    void emit( \
+        EventId event, \
+        const Value& arg0, \
+        const Value& arg1, \
+        const Value& arg2) { \
+        EE->emit(event, arg0, arg1, arg2); \
     }
 
 }  // namespace events
@@ -4,13 +4,78 @@
 #define LIBNODE_FILE_SYSTEM_H_
 
 #include <libj/js_function.h>
+#include <libj/js_object.h>
 #include <libj/string.h>
 
+#include "libnode/buffer.h"
+#include "libnode/fs_read_stream.h"
+#include "libnode/fs_write_stream.h"
+
 namespace libj {
 namespace node {
 namespace fs {
 
+// options of createReadStream and createWriteStream
+extern const String::CPtr HIGH_WATER_MARK;
+extern const String::CPtr START;
+extern const String::CPtr END;
+extern const String::CPtr FLAGS;
+extern const String::CPtr SYNC;
+
+// values of SYNC. with SYNC_WRITE, every write to the file is followed by
+// fdatasync(2), and with SYNC_END only the last one before closing.
+extern const String::CPtr SYNC_NONE;
+extern const String::CPtr SYNC_WRITE;
+extern const String::CPtr SYNC_END;
+
+// options of mmap, and values of ADVICE passed to madvise(2)
+extern const String::CPtr ADVICE;
+extern const String::CPtr ADVICE_NORMAL;
+extern const String::CPtr ADVICE_SEQUENTIAL;
+extern const String::CPtr ADVICE_RANDOM;
+extern const String::CPtr ADVICE_WILLNEED;
+
+// the callback is called with an error code, which is 0 on success,
+// and the content as a Buffer, or as a String decoded with 'enc'
 void readFile(String::CPtr fileName, JsFunction::Ptr callback);
+void readFile(
+    String::CPtr fileName,
+    String::Encoding enc,
+    JsFunction::Ptr callback);
+
+// lets readFile keep up to 'maxBytes' of file contents in memory, the
+// least recently used dropped first. a cached file is dropped as soon as
+// it changes, and its Buffers are read-only. 0, the default, disables
+// the cache.
+void setReadCacheSize(Size maxBytes);
+
+// emits the file in Buffers of up to HIGH_WATER_MARK bytes (64 KiB by
+// default), from START to END inclusive if given
+ReadStream::Ptr createReadStream(String::CPtr path);
+ReadStream::Ptr createReadStream(String::CPtr path, JsObject::CPtr options);
+
+// FLAGS is "w" to truncate (the default) or "a" to append. write() returns
+// false once HIGH_WATER_MARK bytes (64 KiB by default) are queued.
+WriteStream::Ptr createWriteStream(String::CPtr path);
+WriteStream::Ptr createWriteStream(String::CPtr path, JsObject::CPtr options);
+
+// 'data' is a Buffer, or anything else written as the UTF-8 of its string
+// form. the callback is called with an error code, which is 0 on success.
+void writeFile(
+    String::CPtr fileName,
+    Object::CPtr data,
+    JsFunction::Ptr callback);
+void appendFile(
+    String::CPtr fileName,
+    Object::CPtr data,
+    JsFunction::Ptr callback);
+
+// maps a regular file into memory, and returns a read-only Buffer over
+// it, or null on failure. the file is unmapped when the Buffer is gone.
+// the mapping is shared, so its pages come from the page cache, and
+// changes made to the file afterwards may show up in the Buffer.
+Buffer::CPtr mmap(String::CPtr path);
+Buffer::CPtr mmap(String::CPtr path, JsObject::CPtr options);
 
 }  // namespace fs
 }  // namespace node
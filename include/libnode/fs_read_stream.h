@@ -0,0 +1,38 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_FS_READ_STREAM_H_
+#define LIBNODE_FS_READ_STREAM_H_
+
+#include "libnode/stream_writable.h"
+
+namespace libj {
+namespace node {
+namespace fs {
+
+class ReadStream : LIBNODE_EVENT_EMITTER(ReadStream)
+ public:
+    static const EventId EVENT_OPEN;
+    static const EventId EVENT_DATA;
+    static const EventId EVENT_END;
+    static const EventId EVENT_ERROR;
+    static const EventId EVENT_CLOSE;
+
+    virtual String::CPtr path() const = 0;
+    virtual Size bytesRead() const = 0;
+    virtual Boolean isPaused() const = 0;
+
+    // no 'data' is emitted while paused. a read in progress completes.
+    virtual void pause() = 0;
+    virtual void resume() = 0;
+    virtual void destroy() = 0;
+
+    // writes the data to 'dest', pausing whenever write() returns false
+    // until 'dest' emits 'drain', and ends 'dest' at the end of the file
+    virtual void pipe(stream::Writable::Ptr dest) = 0;
+};
+
+}  // namespace fs
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_FS_READ_STREAM_H_
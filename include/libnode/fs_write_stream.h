@@ -0,0 +1,35 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_FS_WRITE_STREAM_H_
+#define LIBNODE_FS_WRITE_STREAM_H_
+
+#include <libj/js_function.h>
+
+#include "libnode/stream_writable.h"
+
+namespace libj {
+namespace node {
+namespace fs {
+
+// chunks written until the current callback returns, or while a write
+// is in progress, go to the file together in a single writev(2)
+class WriteStream : LIBNODE_STREAM_WRITABLE(WriteStream)
+ public:
+    static const EventId EVENT_OPEN;
+    static const EventId EVENT_ERROR;
+    static const EventId EVENT_FINISH;
+    static const EventId EVENT_CLOSE;
+
+    virtual String::CPtr path() const = 0;
+    virtual Size bytesWritten() const = 0;
+
+    // writes out what has been written so far and syncs it to the disk,
+    // then calls the callback with an error code, which is 0 on success
+    virtual void flush(JsFunction::Ptr callback) = 0;
+};
+
+}  // namespace fs
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_FS_WRITE_STREAM_H_
@@ -12,9 +12,9 @@ namespace http {
 class Server : LIBNODE_EVENT_EMITTER(Server)
  public:
     static const String::CPtr IN_ADDR_ANY;
-    static const String::CPtr EVENT_REQUEST;
-    static const String::CPtr EVENT_CONNECTION;
-    static const String::CPtr EVENT_CLOSE;
+    static const EventId EVENT_REQUEST;
+    static const EventId EVENT_CONNECTION;
+    static const EventId EVENT_CLOSE;
 
     static Ptr create();
     static Ptr create(JsFunction::Ptr requestListener);
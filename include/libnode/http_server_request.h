@@ -11,15 +11,19 @@ namespace http {
 
 class ServerRequest : LIBNODE_EVENT_EMITTER(ServerRequest)
  public:
-    static const String::CPtr EVENT_DATA;
-    static const String::CPtr EVENT_END;
-    static const String::CPtr EVENT_CLOSE;
+    static const EventId EVENT_DATA;
+    static const EventId EVENT_END;
+    static const EventId EVENT_CLOSE;
 
     virtual String::CPtr method() const = 0;
     virtual String::CPtr url() const = 0;
     virtual JsObject::CPtr headers() const = 0;
     virtual String::CPtr httpVersion() const = 0;
     virtual net::Socket::Ptr connection() const = 0;
+
+    // 'data' is emitted with Strings of the body, or once this is set,
+    // with Buffers of its bytes, as binary bodies such as uploads need
+    virtual void setBinary(Boolean binary) = 0;
 };
 
 }  // namespace http
@@ -3,23 +3,24 @@
 #ifndef LIBNODE_HTTP_SERVER_RESPONSE_H_
 #define LIBNODE_HTTP_SERVER_RESPONSE_H_
 
-#include "libnode/event_emitter.h"
+#include "libnode/stream_writable.h"
 
 namespace libj {
 namespace node {
 namespace http {
 
-class ServerResponse : LIBNODE_EVENT_EMITTER(ServerResponse)
+// a body of up to 16 KiB written before end() is sent in one piece with
+// a Content-Length. beyond that, the head is sent and the body streamed,
+// with chunked encoding unless a Content-Length header has been set.
+class ServerResponse : LIBNODE_STREAM_WRITABLE(ServerResponse)
  public:
-    static const String::CPtr EVENT_CLOSE;
+    static const EventId EVENT_CLOSE;
 
     virtual Boolean writeHead(Int statusCode) = 0;
     virtual Int statusCode() const = 0;
     virtual void setHeader(String::CPtr name, String::CPtr value) = 0;
     virtual String::CPtr getHeader(String::CPtr name) const = 0;
     virtual void removeHeader(String::CPtr name) = 0;
-    virtual void write(Object::CPtr chunk) = 0;
-    virtual void end() = 0;
 };
 
 }  // namespace http
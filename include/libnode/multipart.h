@@ -0,0 +1,64 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_MULTIPART_H_
+#define LIBNODE_MULTIPART_H_
+
+#include "libnode/buffer.h"
+#include "libnode/stream_writable.h"
+
+namespace libj {
+namespace node {
+namespace multipart {
+
+// parses a multipart body, such as multipart/form-data, as it arrives.
+// 'part' is emitted with a JsObject of the headers of each part, named
+// in lowercase, then 'data' with Buffers of its body and 'partEnd'. the
+// Buffers are slices of the chunks written, or copies of the few bytes
+// held back while a boundary may span two chunks, so that no part is
+// ever kept whole. 'end' is emitted after the closing boundary, and
+// 'error' with an Error code, after which the rest is ignored. 'drain'
+// is emitted when a destination of pipe() which was full has drained.
+class Parser : LIBNODE_EVENT_EMITTER(Parser)
+ public:
+    static const EventId EVENT_PART;
+    static const EventId EVENT_DATA;
+    static const EventId EVENT_PART_END;
+    static const EventId EVENT_END;
+    static const EventId EVENT_ERROR;
+    static const EventId EVENT_DRAIN;
+
+    enum Error {
+        MALFORMED_BOUNDARY = 1,
+        MALFORMED_HEADER,
+        HEADER_TOO_LARGE,
+        UNEXPECTED_END
+    };
+
+    // null if 'boundary' is empty, longer than 70 characters, or has
+    // characters other than printable ASCII ones
+    static Ptr create(String::CPtr boundary);
+
+    // the next chunk of the body. the Buffer must not be written to
+    // while the slices of it emitted are in use. false after the end or
+    // an error, or while the destination of pipe() is full, in which
+    // case the next chunk should wait for 'drain'.
+    virtual Boolean write(Buffer::CPtr chunk) = 0;
+
+    // the end of the body, which is an error before the closing boundary
+    virtual void end() = 0;
+
+    // the rest of the data of the current part is written to 'dest'
+    // instead of being emitted, and 'dest' is ended with the part. to be
+    // called from a 'part' listener, e.g. with an fs::WriteStream.
+    virtual void pipe(stream::Writable::Ptr dest) = 0;
+};
+
+// the boundary parameter of a Content-Type such as 'multipart/form-data;
+// boundary=xyz', unquoted, or null if it has none
+String::CPtr boundaryOf(String::CPtr contentType);
+
+}  // namespace multipart
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_MULTIPART_H_
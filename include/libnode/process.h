@@ -0,0 +1,21 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_PROCESS_H_
+#define LIBNODE_PROCESS_H_
+
+#include <libj/js_array.h>
+#include <libj/js_function.h>
+
+namespace libj {
+namespace node {
+namespace process {
+
+// calls the callback once the current callback returns into the loop,
+// before any further I/O, timer or immediate
+void nextTick(JsFunction::Ptr callback, JsArray::Ptr args);
+
+}  // namespace process
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_PROCESS_H_
@@ -0,0 +1,42 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_QUERYSTRING_H_
+#define LIBNODE_QUERYSTRING_H_
+
+#include <libj/js_object.h>
+#include <libj/string.h>
+
+namespace libj {
+namespace node {
+namespace querystring {
+
+// an object of the keys and values of 'str', split at the ASCII
+// characters 'sep' and 'eq' and unescaped. a key given more than once
+// maps to a JsArray of its values, in order. no more than 'maxKeys'
+// pairs are taken, unless it is 0.
+JsObject::Ptr parse(
+    String::CPtr str,
+    Char sep = '&',
+    Char eq = '=',
+    Size maxKeys = 1000);
+
+// the reverse of parse(). JsArray values are given as repeated keys, and
+// other values which are not Strings as String::valueOf() of them.
+String::CPtr stringify(
+    JsObject::CPtr obj,
+    Char sep = '&',
+    Char eq = '=');
+
+// percent-encodes the UTF-8 bytes of all but the unreserved characters
+// of encodeURIComponent()
+String::CPtr escape(String::CPtr str);
+
+// decodes '%XX' and '+'. a '%' not followed by two hex digits is kept,
+// and bytes which are not valid UTF-8 are decoded to U+FFFD.
+String::CPtr unescape(String::CPtr str);
+
+}  // namespace querystring
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_QUERYSTRING_H_
@@ -0,0 +1,31 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef LIBNODE_STREAM_WRITABLE_H_
+#define LIBNODE_STREAM_WRITABLE_H_
+
+#include "libnode/event_emitter.h"
+
+namespace libj {
+namespace node {
+namespace stream {
+
+class Writable : LIBNODE_EVENT_EMITTER(Writable)
+ public:
+    static const EventId EVENT_DRAIN;
+    static const EventId EVENT_CLOSE;
+
+    // returns false once the data queued for writing reaches the high
+    // water mark, after which 'drain' is emitted when it has gone down
+    virtual Boolean write(Object::CPtr chunk) = 0;
+    virtual void end() = 0;
+};
+
+#define LIBNODE_STREAM_WRITABLE(T) \
+    public libj::node::stream::Writable { \
+    LIBJ_MUTABLE_DECLS(T, libj::node::stream::Writable)
+
+}  // namespace stream
+}  // namespace node
+}  // namespace libj
+
+#endif  // LIBNODE_STREAM_WRITABLE_H_
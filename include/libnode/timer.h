@@ -14,6 +14,28 @@ Value setInterval(JsFunction::Ptr callback, Int delay, JsArray::Ptr args);
 void clearTimeout(Value timeoutId);
 void clearInterval(Value intervalId);
 
+// an unrefed timer still fires, but does not keep the loop alive by itself
+void refTimer(Value timerId);
+void unrefTimer(Value timerId);
+
+// lets the timer fire up to 'slack' milliseconds late, so that timers
+// due at nearby times are run by a single wakeup of the loop
+void setTimerSlack(Value timerId, Int slack);
+
+// runs the callback on the next turn of the loop, after pending I/O
+Value setImmediate(JsFunction::Ptr callback, JsArray::Ptr args);
+void clearImmediate(Value immediateId);
+
+// runs the callback when the loop has no I/O to handle, in a small time
+// slice shared with the other idle callbacks, higher priorities first.
+// after 'timeout' milliseconds it runs regardless, unless timeout is 0.
+Value requestIdleCallback(
+    JsFunction::Ptr callback,
+    JsArray::Ptr args,
+    Int timeout,
+    Int priority);
+void cancelIdleCallback(Value idleId);
+
 }  // namespace node
 }  // namespace libj
 
@@ -22,9 +22,22 @@ extern const String::CPtr PATH;
 extern const String::CPtr QUERY;
 extern const String::CPtr HASH;
 
-JsObject::Ptr parse(String::CPtr urlStr);
+// with 'parseQueryString', the query is given as an object made by
+// querystring::parse(), which is empty if there is no query
+JsObject::Ptr parse(String::CPtr urlStr, Boolean parseQueryString = false);
 String::CPtr format(JsObject::CPtr urlObj);
 
+// the canonical form of the path of a URL, with escaped unreserved
+// characters decoded, the hex digits of the other escapes in uppercase,
+// empty and '.' segments removed and '..' segments resolved. 'path' is
+// returned as it is if it is canonical already, and null if it has
+// a malformed escape or a '..' above the root.
+String::CPtr normalizePath(String::CPtr path);
+
+// the file under the directory 'root' which the path of a URL names, or
+// null if normalizePath() fails or an escape stands for '/', '\\' or NUL
+String::CPtr toFilePath(String::CPtr root, String::CPtr path);
+
 }  // namespace url
 }  // namespace node
 }  // namespace libj
@@ -3,6 +3,7 @@
 #include <libj/console.h>
 #include <libj/json.h>
 
+#include "libnode/buffer_list.h"
 #include "libnode/http_server.h"
 #include "libnode/http_server_request.h"
 #include "libnode/http_server_response.h"
@@ -13,17 +14,17 @@ namespace node {
 
 class OnData : LIBJ_JS_FUNCTION(OnData)
  private:
-    String::CPtr body_;
+    BufferList body_;
 
  public:
-    OnData() : body_(String::create()) {}
-
-    String::CPtr getBody() const { return body_; }
+    String::CPtr getBody() {
+        return body_.flatten()->toString(Buffer::UTF8);
+    }
 
     Value operator()(JsArray::Ptr args) {
         String::CPtr chunk = toCPtr<String>(args->get(0));
         if (chunk)
-            body_ = body_->concat(chunk);
+            body_.append(chunk);
         return 0;
     }
 };
@@ -1,5 +1,7 @@
 // Copyright (c) 2012 Plenluno All rights reserved.
 
+#include <unistd.h>
+
 #include "libnode/file_system.h"
 #include "libnode/http_server.h"
 #include "libnode/http_server_request.h"
@@ -13,26 +15,18 @@ static libj::String::CPtr root;
 namespace libj {
 namespace node {
 
-class OnRead : LIBJ_JS_FUNCTION(OnRead)
+class OnError : LIBJ_JS_FUNCTION(OnError)
  private:
     http::ServerResponse::Ptr res_;
 
  public:
-    OnRead(http::ServerResponse::Ptr res) : res_(res) {}
+    OnError(http::ServerResponse::Ptr res) : res_(res) {}
 
     Value operator()(JsArray::Ptr args) {
-        String::CPtr content = toCPtr<String>(args->get(1));
-        res_->setHeader(
-            String::create("Content-Type"),
-            String::create("text/plain"));
-        if (content) {
-            res_->write(content);
-        } else {
-            http::Status::CPtr status404 =
-                http::Status::create(http::Status::NOT_FOUND);
-            res_->writeHead(status404->code());
-            res_->write(status404->message());
-        }
+        http::Status::CPtr status404 =
+            http::Status::create(http::Status::NOT_FOUND);
+        res_->writeHead(status404->code());
+        res_->write(status404->message());
         res_->end();
         return 0;
     }
@@ -45,11 +39,21 @@ class OnRequest : LIBJ_JS_FUNCTION(OnRequest)
             toPtr<http::ServerRequest>(args->get(0));
         http::ServerResponse::Ptr res =
             toPtr<http::ServerResponse>(args->get(1));
+        OnError::Ptr onError(new OnError(res));
         JsObject::Ptr url = url::parse(req->url());
-        OnRead::Ptr onRead(new OnRead(res));
-        fs::readFile(
-            root->concat(toCPtr<String>(url->get(url::PATHNAME))),
-            onRead);
+        String::CPtr path = url::toFilePath(
+            root, toCPtr<String>(url->get(url::PATHNAME)));
+        if (!path) {
+            (*onError)(JsArray::create());
+            return 0;
+        }
+
+        fs::ReadStream::Ptr stream = fs::createReadStream(path);
+        res->setHeader(
+            String::create("Content-Type"),
+            String::create("text/plain"));
+        stream->on(fs::ReadStream::EVENT_ERROR, onError);
+        stream->pipe(res);
         return 0;
     }
 };
@@ -1,3 +1,549 @@
 // Copyright (c) 2012 Plenluno All rights reserved.
 
+#include <string.h>
+#include <string>
+
 #include "libnode/buffer.h"
+#include "./buffer_codec.h"
+#include "./buffer_search.h"
+#include "./buffer_view.h"
+
+namespace libj {
+namespace node {
+
+static void appendUtf16(std::string* s, Char c, Boolean littleEndian) {
+    UShort units[2];
+    Size n = 1;
+    if (c >= 0x10000) {
+        c -= 0x10000;
+        units[0] = static_cast<UShort>(0xd800 + (c >> 10));
+        units[1] = static_cast<UShort>(0xdc00 + (c & 0x3ff));
+        n = 2;
+    } else {
+        units[0] = static_cast<UShort>(c);
+    }
+    for (Size i = 0; i < n; i++) {
+        char hi = static_cast<char>(units[i] >> 8);
+        char lo = static_cast<char>(units[i] & 0xff);
+        s->push_back(littleEndian ? lo : hi);
+        s->push_back(littleEndian ? hi : lo);
+    }
+}
+
+static void appendUtf32(std::string* s, Char c, Boolean littleEndian) {
+    for (Size i = 0; i < 4; i++) {
+        Size shift = littleEndian ? i * 8 : (3 - i) * 8;
+        s->push_back(static_cast<char>((c >> shift) & 0xff));
+    }
+}
+
+static std::string encode(String::CPtr str, String::Encoding enc) {
+    if (enc == String::UTF8)
+        return str->toStdString();
+
+    std::string s;
+    Size len = str->length();
+    for (Size i = 0; i < len; i++) {
+        Char c = str->charAt(i);
+        switch (enc) {
+        case String::ASCII:
+            s.push_back(static_cast<char>(c & 0x7f));
+            break;
+        case String::UTF16BE:
+            appendUtf16(&s, c, false);
+            break;
+        case String::UTF16LE:
+            appendUtf16(&s, c, true);
+            break;
+        case String::UTF32BE:
+            appendUtf32(&s, c, false);
+            break;
+        case String::UTF32LE:
+            appendUtf32(&s, c, true);
+            break;
+        default:
+            break;
+        }
+    }
+    return s;
+}
+
+class BufferImpl : public Buffer {
+ public:
+    static Ptr create(Size length) {
+        Ptr p(new BufferImpl(length));
+        return p;
+    }
+
+    static Ptr create(JsTypedArray<UByte>::CPtr array) {
+        if (!array) {
+            LIBJ_NULL_PTR(Buffer, nullp);
+            return nullp;
+        }
+
+        Size len = array->size();
+        Ptr p(new BufferImpl(len));
+        for (Size i = 0; i < len; i++) {
+            UByte b = 0;
+            to<UByte>(array->get(i), &b);
+            p->setUInt8(i, b);
+        }
+        return p;
+    }
+
+    static Ptr create(String::CPtr str, String::Encoding enc) {
+        if (!str) {
+            LIBJ_NULL_PTR(Buffer, nullp);
+            return nullp;
+        }
+
+        std::string s = encode(str, enc);
+        Ptr p = Buffer::create(s.length());
+        memcpy(const_cast<void*>(p->data()), s.data(), s.length());
+        return p;
+    }
+
+    void write(
+        String::CPtr str,
+        Size offset,
+        Size length,
+        String::Encoding enc) {
+        Size len = buffer_->length();
+        if (!str || offset >= len)
+            return;
+
+        std::string s = encode(str, enc);
+        Size n = len - offset;
+        if (length < n) n = length;
+        if (s.length() < n) n = s.length();
+        memcpy(bytes() + offset, s.data(), n);
+    }
+
+    Boolean isReadOnly() const {
+        return false;
+    }
+
+    Ptr slice(Size start, Size end) const {
+        Size len = buffer_->length();
+        if (end > len) end = len;
+        if (start > end) start = end;
+        const UByte* data = static_cast<const UByte*>(buffer_->data());
+        Ptr p(new BufferView(data + start, end - start, false, buffer_));
+        return p;
+    }
+
+ private:
+    JsArrayBuffer::Ptr buffer_;
+
+    BufferImpl(Size length)
+        : buffer_(JsArrayBuffer::create(length)) {}
+
+    UByte* bytes() {
+        return static_cast<UByte*>(const_cast<void*>(buffer_->data()));
+    }
+
+    LIBJ_JS_ARRAY_BUFFER_IMPL(buffer_);
+};
+
+namespace {
+    const Size kDefaultSlabLength = 8 * 1024;
+    const Size kDefaultPoolThreshold = 4 * 1024;
+
+    // pooled Buffers start at multiples of this
+    const Size kPoolAlignment = 8;
+
+    Size slabLength = kDefaultSlabLength;
+    Size poolThreshold = kDefaultPoolThreshold;
+    Buffer::CPtr slab = LIBJ_NULL(Buffer);
+    Size slabOffset = 0;
+
+    Buffer::Ptr allocPooled(Size length) {
+        if (!slab || slabOffset + length > slab->length()) {
+            slab = BufferImpl::create(slabLength);
+            slabOffset = 0;
+        }
+
+        UByte* data = static_cast<UByte*>(const_cast<void*>(slab->data()));
+        data += slabOffset;
+        memset(data, 0, length);
+        slabOffset += (length + kPoolAlignment - 1) & ~(kPoolAlignment - 1);
+        Buffer::Ptr p(new BufferView(data, length, false, slab));
+        return p;
+    }
+}
+
+Buffer::Ptr Buffer::create(Size length) {
+    if (length && length < poolThreshold) {
+        return allocPooled(length);
+    } else {
+        return BufferImpl::create(length);
+    }
+}
+
+Buffer::Ptr Buffer::concat(JsArray::CPtr list, Size totalLength) {
+    if (!list) {
+        LIBJ_NULL_PTR(Buffer, nullp);
+        return nullp;
+    }
+
+    Size num = list->size();
+    if (totalLength == NO_POS) {
+        totalLength = 0;
+        for (Size i = 0; i < num; i++) {
+            Buffer::CPtr b = toCPtr<Buffer>(list->get(i));
+            if (b)
+                totalLength += b->length();
+        }
+    }
+
+    Ptr p = create(totalLength);
+    UByte* dst = static_cast<UByte*>(const_cast<void*>(p->data()));
+    Size pos = 0;
+    for (Size i = 0; i < num && pos < totalLength; i++) {
+        Buffer::CPtr b = toCPtr<Buffer>(list->get(i));
+        if (!b)
+            continue;
+        Size n = b->length();
+        if (n > totalLength - pos)
+            n = totalLength - pos;
+        memcpy(dst + pos, b->data(), n);
+        pos += n;
+    }
+    return p;
+}
+
+Size Buffer::copy(
+    Ptr target,
+    Size targetStart,
+    Size sourceStart,
+    Size sourceEnd) const {
+    Size len = length();
+    if (!target || target->isReadOnly())
+        return 0;
+    if (sourceEnd > len) sourceEnd = len;
+    if (sourceStart >= sourceEnd || targetStart >= target->length())
+        return 0;
+
+    Size n = sourceEnd - sourceStart;
+    if (n > target->length() - targetStart)
+        n = target->length() - targetStart;
+    UByte* dst = static_cast<UByte*>(const_cast<void*>(target->data()));
+    const UByte* src = static_cast<const UByte*>(data());
+    memmove(dst + targetStart, src + sourceStart, n);
+    return n;
+}
+
+static UByte* bytesOf(Buffer::Ptr buf) {
+    return static_cast<UByte*>(const_cast<void*>(buf->data()));
+}
+
+// the Buffer shrunk to the first 'len' bytes decoded into it
+static Buffer::Ptr fit(Buffer::Ptr buf, Size len) {
+    return len < buf->length() ? buf->slice(0, len) : buf;
+}
+
+Buffer::Ptr Buffer::create(String::CPtr str, Encoding enc) {
+    if (!str) {
+        LIBJ_NULL_PTR(Buffer, nullp);
+        return nullp;
+    }
+
+    switch (enc) {
+    case ASCII:
+    case LATIN1:
+        {
+            std::string s = str->toStdString();
+            const UByte* src = reinterpret_cast<const UByte*>(s.data());
+            if (codec::isAscii(src, s.length()))
+                return create(str, String::UTF8);
+
+            Size len = str->length();
+            Ptr p = create(len);
+            UByte* dst = bytesOf(p);
+            for (Size i = 0; i < len; i++)
+                dst[i] = static_cast<UByte>(str->charAt(i));
+            return p;
+        }
+    case HEX:
+        {
+            std::string s = str->toStdString();
+            Ptr p = create(s.length() / 2);
+            return fit(p, codec::hexDecode(s.data(), s.length(), bytesOf(p)));
+        }
+    case BASE64:
+    case BASE64URL:
+        {
+            std::string s = str->toStdString();
+            Ptr p = create(codec::base64DecodedLength(s.length()));
+            Size n = codec::base64Decode(
+                s.data(), s.length(), bytesOf(p), p->length());
+            return fit(p, n);
+        }
+    default:
+        return create(str, String::UTF8);
+    }
+}
+
+Size Buffer::write(
+    String::CPtr str,
+    Encoding enc,
+    Size offset,
+    Size length) {
+    Size len = this->length();
+    if (!str || isReadOnly() || offset >= len)
+        return 0;
+
+    Size n = len - offset;
+    if (length < n) n = length;
+    UByte* dst = static_cast<UByte*>(const_cast<void*>(data())) + offset;
+
+    // hex and base64 are decoded in place, the others through a Buffer
+    if (enc == HEX) {
+        std::string s = str->toStdString();
+        Size max = s.length() < 2 * n ? s.length() : 2 * n;
+        return codec::hexDecode(s.data(), max, dst);
+    } else if (enc == BASE64 || enc == BASE64URL) {
+        std::string s = str->toStdString();
+        return codec::base64Decode(s.data(), s.length(), dst, n);
+    } else {
+        Ptr b = create(str, enc);
+        if (b->length() < n)
+            n = b->length();
+        memcpy(dst, b->data(), n);
+        return n;
+    }
+}
+
+String::CPtr Buffer::toString(Encoding enc, Size start, Size end) const {
+    Size len = length();
+    if (end > len) end = len;
+    if (start > end) start = end;
+
+    const UByte* src = static_cast<const UByte*>(data()) + start;
+    const char* chars = reinterpret_cast<const char*>(src);
+    Size n = end - start;
+    std::string s;
+    switch (enc) {
+    case UTF8:
+        {
+            Size valid = codec::validUtf8Prefix(src, n);
+            if (valid == n)
+                return String::create(chars, String::UTF8, n);
+
+            // each byte which starts no valid sequence becomes U+FFFD
+            Size i = 0;
+            while (i < n) {
+                s.append(chars + i, valid);
+                i += valid;
+                if (i < n) {
+                    s.append("\xef\xbf\xbd");
+                    i++;
+                }
+                valid = codec::validUtf8Prefix(src + i, n - i);
+            }
+            break;
+        }
+    case ASCII:
+    case LATIN1:
+        if (codec::isAscii(src, n))
+            return String::create(chars, String::UTF8, n);
+
+        s.reserve(2 * n);
+        for (Size i = 0; i < n; i++) {
+            UByte c = src[i];
+            if (enc == ASCII || c < 0x80) {
+                s.push_back(static_cast<char>(c & 0x7f));
+            } else {
+                s.push_back(static_cast<char>(0xc0 | (c >> 6)));
+                s.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+            }
+        }
+        break;
+    case HEX:
+        s.resize(2 * n);
+        if (n)
+            codec::hexEncode(src, n, &s[0]);
+        break;
+    case BASE64:
+    case BASE64URL:
+        s.resize(codec::base64EncodedLength(n));
+        if (n)
+            s.resize(codec::base64Encode(src, n, &s[0], enc == BASE64URL));
+        break;
+    }
+    return String::create(s.data(), String::UTF8, s.length());
+}
+
+Boolean Buffer::isUtf8() const {
+    const UByte* src = static_cast<const UByte*>(data());
+    return codec::validUtf8Prefix(src, length()) == length();
+}
+
+static Size indexOfBytes(
+    const Buffer* buf,
+    const void* value,
+    Size len,
+    Size byteOffset) {
+    Size size = buf->length();
+    if (byteOffset > size)
+        return NO_POS;
+
+    const UByte* src = static_cast<const UByte*>(buf->data());
+    Size pos = search::indexOf(
+        src + byteOffset,
+        size - byteOffset,
+        static_cast<const UByte*>(value),
+        len);
+    return pos == NO_POS ? NO_POS : byteOffset + pos;
+}
+
+static Size lastIndexOfBytes(
+    const Buffer* buf,
+    const void* value,
+    Size len,
+    Size byteOffset) {
+    Size size = buf->length();
+    if (len > size)
+        return NO_POS;
+
+    // a match may start at 'byteOffset', and so end 'len' bytes later
+    if (byteOffset < size - len)
+        size = byteOffset + len;
+    return search::lastIndexOf(
+        static_cast<const UByte*>(buf->data()),
+        size,
+        static_cast<const UByte*>(value),
+        len);
+}
+
+Size Buffer::indexOf(UByte value, Size byteOffset) const {
+    Size size = length();
+    if (byteOffset >= size)
+        return NO_POS;
+
+    const UByte* src = static_cast<const UByte*>(data());
+    Size pos = search::indexOf(src + byteOffset, size - byteOffset, value);
+    return pos == NO_POS ? NO_POS : byteOffset + pos;
+}
+
+Size Buffer::indexOf(String::CPtr value, Size byteOffset) const {
+    if (!value)
+        return NO_POS;
+
+    std::string s = value->toStdString();
+    return indexOfBytes(this, s.data(), s.length(), byteOffset);
+}
+
+Size Buffer::indexOf(CPtr value, Size byteOffset) const {
+    if (!value)
+        return NO_POS;
+
+    return indexOfBytes(this, value->data(), value->length(), byteOffset);
+}
+
+Size Buffer::lastIndexOf(UByte value, Size byteOffset) const {
+    return lastIndexOfBytes(this, &value, 1, byteOffset);
+}
+
+Size Buffer::lastIndexOf(String::CPtr value, Size byteOffset) const {
+    if (!value)
+        return NO_POS;
+
+    std::string s = value->toStdString();
+    return lastIndexOfBytes(this, s.data(), s.length(), byteOffset);
+}
+
+Size Buffer::lastIndexOf(CPtr value, Size byteOffset) const {
+    if (!value)
+        return NO_POS;
+
+    return lastIndexOfBytes(this, value->data(), value->length(), byteOffset);
+}
+
+Int Buffer::compare(CPtr target) const {
+    if (!target)
+        return 1;
+
+    Size len = length();
+    Size targetLen = target->length();
+    Int r = memcmp(data(), target->data(), len < targetLen ? len : targetLen);
+    if (!r)
+        r = len < targetLen ? -1 : len > targetLen ? 1 : 0;
+    return r < 0 ? -1 : r > 0 ? 1 : 0;
+}
+
+Boolean Buffer::equals(CPtr target) const {
+    return target
+        && target->length() == length()
+        && !memcmp(target->data(), data(), length());
+}
+
+static Boolean fillBytes(
+    Buffer* buf,
+    const void* value,
+    Size len,
+    Size start,
+    Size end) {
+    if (buf->isReadOnly())
+        return false;
+
+    Size size = buf->length();
+    if (end > size) end = size;
+    if (start >= end)
+        return true;
+
+    UByte* dst = static_cast<UByte*>(const_cast<void*>(buf->data())) + start;
+    Size n = end - start;
+    if (len <= 1) {
+        memset(dst, len ? *static_cast<const UByte*>(value) : 0, n);
+        return true;
+    }
+
+    // the pattern is copied once, and then what is filled doubles
+    Size filled = len < n ? len : n;
+    memcpy(dst, value, filled);
+    while (filled < n) {
+        Size m = filled < n - filled ? filled : n - filled;
+        memcpy(dst + filled, dst, m);
+        filled += m;
+    }
+    return true;
+}
+
+Boolean Buffer::fill(UByte value, Size start, Size end) {
+    return fillBytes(this, &value, 1, start, end);
+}
+
+Boolean Buffer::fill(String::CPtr value, Size start, Size end) {
+    std::string s = value ? value->toStdString() : std::string();
+    return fillBytes(this, s.data(), s.length(), start, end);
+}
+
+Boolean Buffer::fill(CPtr value, Size start, Size end) {
+    if (!value)
+        return fillBytes(this, 0, 0, start, end);
+
+    // a copy of the pattern, in case it overlaps the range
+    std::string s(static_cast<const char*>(value->data()), value->length());
+    return fillBytes(this, s.data(), s.length(), start, end);
+}
+
+void Buffer::setPool(Size slabLen, Size threshold) {
+    if (threshold > slabLen)
+        threshold = slabLen;
+    slabLength = slabLen;
+    poolThreshold = threshold;
+    slab = LIBJ_NULL(Buffer);
+    slabOffset = 0;
+}
+
+Buffer::Ptr Buffer::create(JsTypedArray<UByte>::CPtr array) {
+    return BufferImpl::create(array);
+}
+
+Buffer::Ptr Buffer::create(String::CPtr str, String::Encoding enc) {
+    return BufferImpl::create(str, enc);
+}
+
+}  // namespace node
+}  // namespace libj
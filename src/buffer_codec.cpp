@@ -0,0 +1,483 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+# define LIBNODE_CODEC_X86
+# include <immintrin.h>
+#endif
+
+#include "./buffer_codec.h"
+
+namespace libj {
+namespace node {
+namespace codec {
+
+namespace {
+    const char kBase64[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const char kBase64Url[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    const char kHex[] = "0123456789abcdef";
+
+    const Byte kInvalid = -1;
+    const Byte kPad = -2;
+
+    struct DecodeTable {
+        Byte base64[256];
+        Byte hex[256];
+
+        DecodeTable() {
+            memset(base64, kInvalid, sizeof(base64));
+            memset(hex, kInvalid, sizeof(hex));
+            for (Byte i = 0; i < 64; i++) {
+                base64[static_cast<UByte>(kBase64[i])] = i;
+                base64[static_cast<UByte>(kBase64Url[i])] = i;
+            }
+            base64[static_cast<UByte>('=')] = kPad;
+            for (Byte i = 0; i < 16; i++) {
+                hex[static_cast<UByte>(kHex[i])] = i;
+                if (i >= 10)
+                    hex[static_cast<UByte>(kHex[i] - 'a' + 'A')] = i;
+            }
+        }
+    };
+
+    const DecodeTable& table() {
+        static const DecodeTable t;
+        return t;
+    }
+
+    // each bulk kernel handles as much of the input as it can in whole
+    // blocks, and returns how much it consumed. the scalar code does the
+    // rest, or all of it where the CPU has no kernel, whose pointer in
+    // Kernels is then null.
+
+#ifdef LIBNODE_CODEC_X86
+    __attribute__((target("sse2")))
+    Size hexEncodeSse2(const UByte* src, Size len, char* dst) {
+        const __m128i mask = _mm_set1_epi8(0x0f);
+        const __m128i nine = _mm_set1_epi8(9);
+        const __m128i zero = _mm_set1_epi8('0');
+        const __m128i alpha = _mm_set1_epi8('a' - '0' - 10);
+        Size i = 0;
+        for (; i + 16 <= len; i += 16) {
+            __m128i in = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(src + i));
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 4), mask);
+            __m128i lo = _mm_and_si128(in, mask);
+            hi = _mm_add_epi8(
+                _mm_add_epi8(hi, zero),
+                _mm_and_si128(_mm_cmpgt_epi8(hi, nine), alpha));
+            lo = _mm_add_epi8(
+                _mm_add_epi8(lo, zero),
+                _mm_and_si128(_mm_cmpgt_epi8(lo, nine), alpha));
+            __m128i* out = reinterpret_cast<__m128i*>(dst + 2 * i);
+            _mm_storeu_si128(out, _mm_unpacklo_epi8(hi, lo));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(hi, lo));
+        }
+        return i;
+    }
+
+    __attribute__((target("sse2")))
+    Size asciiPrefixSse2(const UByte* src, Size len) {
+        Size i = 0;
+        for (; i + 16 <= len; i += 16) {
+            __m128i in = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(src + i));
+            int mask = _mm_movemask_epi8(in);
+            if (mask)
+                return i + __builtin_ctz(mask);
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    Size asciiPrefixAvx2(const UByte* src, Size len) {
+        Size i = 0;
+        for (; i + 32 <= len; i += 32) {
+            __m256i in = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(src + i));
+            unsigned mask = _mm256_movemask_epi8(in);
+            if (mask)
+                return i + __builtin_ctz(mask);
+        }
+        return i + asciiPrefixSse2(src + i, len - i);
+    }
+
+    // base64 after W. Mula and D. Lemire, "Faster Base64 Encoding and
+    // Decoding Using AVX2 Instructions". the 128-bit kernels need SSSE3
+    // for pshufb, and the 256-bit ones apply the same steps per lane.
+
+    __attribute__((target("ssse3")))
+    __m128i base64EncodeBlock(__m128i in, __m128i lut) {
+        in = _mm_shuffle_epi8(in, _mm_set_epi8(
+            10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+        __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+        __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+        __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        __m128i indices = _mm_or_si128(t1, t3);
+
+        __m128i r = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        r = _mm_or_si128(r, _mm_and_si128(less, _mm_set1_epi8(13)));
+        return _mm_add_epi8(_mm_shuffle_epi8(lut, r), indices);
+    }
+
+    __attribute__((target("ssse3")))
+    __m128i base64EncodeLut(Boolean url) {
+        return _mm_setr_epi8(
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            (url ? '-' : '+') - 62, (url ? '_' : '/') - 63, 'A', 0, 0);
+    }
+
+    __attribute__((target("ssse3")))
+    Size base64EncodeSsse3(
+        const UByte* src, Size len, char* dst, Boolean url) {
+        const __m128i lut = base64EncodeLut(url);
+        Size i = 0;
+        for (; i + 16 <= len; i += 12, dst += 16) {
+            __m128i in = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(dst),
+                base64EncodeBlock(in, lut));
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    Size base64EncodeAvx2(
+        const UByte* src, Size len, char* dst, Boolean url) {
+        const __m128i lut128 = base64EncodeLut(url);
+        const __m256i lut = _mm256_broadcastsi128_si256(lut128);
+        const __m256i shuf = _mm256_broadcastsi128_si256(_mm_set_epi8(
+            10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+        Size i = 0;
+        for (; i + 28 <= len; i += 24, dst += 32) {
+            __m256i in = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(src + i))),
+                _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(src + i + 12)),
+                1);
+            in = _mm256_shuffle_epi8(in, shuf);
+            __m256i t0 = _mm256_and_si256(
+                in, _mm256_set1_epi32(0x0fc0fc00));
+            __m256i t1 = _mm256_mulhi_epu16(
+                t0, _mm256_set1_epi32(0x04000040));
+            __m256i t2 = _mm256_and_si256(
+                in, _mm256_set1_epi32(0x003f03f0));
+            __m256i t3 = _mm256_mullo_epi16(
+                t2, _mm256_set1_epi32(0x01000010));
+            __m256i indices = _mm256_or_si256(t1, t3);
+
+            __m256i r = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+            __m256i less = _mm256_cmpgt_epi8(
+                _mm256_set1_epi8(26), indices);
+            r = _mm256_or_si256(
+                r, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+            _mm256_storeu_si256(
+                reinterpret_cast<__m256i*>(dst),
+                _mm256_add_epi8(_mm256_shuffle_epi8(lut, r), indices));
+        }
+        return i + base64EncodeSsse3(src + i, len - i, dst, url);
+    }
+
+    // only the standard alphabet is decoded in blocks. a block with
+    // anything else, such as URL-safe characters, whitespace or padding,
+    // ends the bulk decoding, and the scalar code takes over from it.
+
+    __attribute__((target("ssse3")))
+    Boolean base64DecodeBlock(__m128i in, __m128i* out) {
+        const __m128i lutLo = _mm_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+        const __m128i lutHi = _mm_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i lutRoll = _mm_setr_epi8(
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i mask = _mm_set1_epi8(0x0f);
+
+        __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask);
+        __m128i loNibbles = _mm_and_si128(in, mask);
+        __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+        __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(
+                _mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xffff)
+            return false;
+
+        __m128i eq = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+        __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq, hiNibbles));
+        __m128i indices = _mm_add_epi8(in, roll);
+
+        __m128i ab = _mm_maddubs_epi16(indices, _mm_set1_epi32(0x01400140));
+        __m128i abc = _mm_madd_epi16(ab, _mm_set1_epi32(0x00011000));
+        *out = _mm_shuffle_epi8(abc, _mm_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        return true;
+    }
+
+    __attribute__((target("ssse3")))
+    Size base64DecodeSsse3(
+        const char* src, Size len, UByte* dst, Size dstLen, Size* written) {
+        Size i = 0;
+        Size n = 0;
+        for (; i + 16 <= len && n + 16 <= dstLen; i += 16, n += 12) {
+            __m128i in = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(src + i));
+            __m128i out;
+            if (!base64DecodeBlock(in, &out))
+                break;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n), out);
+        }
+        *written = n;
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    Size base64DecodeAvx2(
+        const char* src, Size len, UByte* dst, Size dstLen, Size* written) {
+        const __m256i lutLo = _mm256_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+        const __m256i lutHi = _mm256_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m256i lutRoll = _mm256_setr_epi8(
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m256i shuf = _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        const __m256i mask = _mm256_set1_epi8(0x0f);
+
+        Size i = 0;
+        Size n = 0;
+        for (; i + 32 <= len && n + 28 <= dstLen; i += 32, n += 24) {
+            __m256i in = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(src + i));
+            __m256i hiNibbles =
+                _mm256_and_si256(_mm256_srli_epi32(in, 4), mask);
+            __m256i loNibbles = _mm256_and_si256(in, mask);
+            __m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+            __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+            if (!_mm256_testz_si256(lo, hi))
+                break;
+
+            __m256i eq = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+            __m256i roll = _mm256_shuffle_epi8(
+                lutRoll, _mm256_add_epi8(eq, hiNibbles));
+            __m256i indices = _mm256_add_epi8(in, roll);
+            __m256i ab = _mm256_maddubs_epi16(
+                indices, _mm256_set1_epi32(0x01400140));
+            __m256i abc = _mm256_madd_epi16(
+                ab, _mm256_set1_epi32(0x00011000));
+            __m256i out = _mm256_shuffle_epi8(abc, shuf);
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(dst + n),
+                _mm256_castsi256_si128(out));
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(dst + n + 12),
+                _mm256_extracti128_si256(out, 1));
+        }
+
+        Size m = 0;
+        i += base64DecodeSsse3(src + i, len - i, dst + n, dstLen - n, &m);
+        *written = n + m;
+        return i;
+    }
+#endif  // LIBNODE_CODEC_X86
+
+    struct Kernels {
+        Size (*base64Encode)(const UByte*, Size, char*, Boolean);
+        Size (*base64Decode)(const char*, Size, UByte*, Size, Size*);
+        Size (*hexEncode)(const UByte*, Size, char*);
+        Size (*asciiPrefix)(const UByte*, Size);
+
+        Kernels()
+            : base64Encode(0)
+            , base64Decode(0)
+            , hexEncode(0)
+            , asciiPrefix(0) {
+#ifdef LIBNODE_CODEC_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("sse2")) {
+                hexEncode = hexEncodeSse2;
+                asciiPrefix = asciiPrefixSse2;
+            }
+            if (__builtin_cpu_supports("ssse3")) {
+                base64Encode = base64EncodeSsse3;
+                base64Decode = base64DecodeSsse3;
+            }
+            if (__builtin_cpu_supports("avx2")) {
+                base64Encode = base64EncodeAvx2;
+                base64Decode = base64DecodeAvx2;
+                asciiPrefix = asciiPrefixAvx2;
+            }
+#endif
+        }
+    };
+
+    const Kernels& kernels() {
+        static const Kernels k;
+        return k;
+    }
+
+    Size asciiPrefix(const UByte* src, Size len) {
+        const Kernels& k = kernels();
+        Size i = k.asciiPrefix ? k.asciiPrefix(src, len) : 0;
+        while (i < len && src[i] < 0x80)
+            i++;
+        return i;
+    }
+}
+
+Size base64EncodedLength(Size len) {
+    return (len + 2) / 3 * 4;
+}
+
+Size base64Encode(const UByte* src, Size len, char* dst, Boolean url) {
+    const char* alphabet = url ? kBase64Url : kBase64;
+    const Kernels& k = kernels();
+    Size i = k.base64Encode ? k.base64Encode(src, len, dst, url) : 0;
+    char* out = dst + i / 3 * 4;
+    for (; i + 3 <= len; i += 3) {
+        UInt v = (src[i] << 16) | (src[i + 1] << 8) | src[i + 2];
+        *out++ = alphabet[v >> 18];
+        *out++ = alphabet[(v >> 12) & 0x3f];
+        *out++ = alphabet[(v >> 6) & 0x3f];
+        *out++ = alphabet[v & 0x3f];
+    }
+    if (i < len) {
+        UInt v = src[i] << 16;
+        if (i + 1 < len)
+            v |= src[i + 1] << 8;
+        *out++ = alphabet[v >> 18];
+        *out++ = alphabet[(v >> 12) & 0x3f];
+        if (i + 1 < len) {
+            *out++ = alphabet[(v >> 6) & 0x3f];
+        } else if (!url) {
+            *out++ = '=';
+        }
+        if (!url)
+            *out++ = '=';
+    }
+    return out - dst;
+}
+
+Size base64DecodedLength(Size len) {
+    return (len + 3) / 4 * 3;
+}
+
+Size base64Decode(const char* src, Size len, UByte* dst, Size dstLen) {
+    const Byte* t = table().base64;
+    const Kernels& k = kernels();
+    Size n = 0;
+    Size i = k.base64Decode ? k.base64Decode(src, len, dst, dstLen, &n) : 0;
+
+    UInt v = 0;
+    Size num = 0;
+    for (; i < len; i++) {
+        Byte d = t[static_cast<UByte>(src[i])];
+        if (d == kPad)
+            break;
+        if (d == kInvalid)
+            continue;
+        v = (v << 6) | d;
+        if (++num == 4) {
+            if (n + 3 > dstLen)
+                return n;
+            dst[n++] = static_cast<UByte>(v >> 16);
+            dst[n++] = static_cast<UByte>(v >> 8);
+            dst[n++] = static_cast<UByte>(v);
+            v = 0;
+            num = 0;
+        }
+    }
+
+    // 2 or 3 characters left over make 1 or 2 more bytes
+    if (num >= 2 && n < dstLen)
+        dst[n++] = static_cast<UByte>(v >> (num == 2 ? 4 : 10));
+    if (num == 3 && n < dstLen)
+        dst[n++] = static_cast<UByte>(v >> 2);
+    return n;
+}
+
+void hexEncode(const UByte* src, Size len, char* dst) {
+    const Kernels& k = kernels();
+    Size i = k.hexEncode ? k.hexEncode(src, len, dst) : 0;
+    for (; i < len; i++) {
+        dst[2 * i] = kHex[src[i] >> 4];
+        dst[2 * i + 1] = kHex[src[i] & 0x0f];
+    }
+}
+
+Size hexDecode(const char* src, Size len, UByte* dst) {
+    const Byte* t = table().hex;
+    Size n = 0;
+    for (Size i = 0; i + 2 <= len; i += 2) {
+        Byte hi = t[static_cast<UByte>(src[i])];
+        Byte lo = t[static_cast<UByte>(src[i + 1])];
+        if (hi < 0 || lo < 0)
+            break;
+        dst[n++] = static_cast<UByte>((hi << 4) | lo);
+    }
+    return n;
+}
+
+Boolean isAscii(const UByte* src, Size len) {
+    return asciiPrefix(src, len) == len;
+}
+
+Size validUtf8Prefix(const UByte* src, Size len) {
+    Size i = 0;
+    while (i < len) {
+        i += asciiPrefix(src + i, len - i);
+        if (i == len)
+            break;
+
+        UByte c = src[i];
+        Size n;
+        Char cp;
+        if (c < 0xc2) {
+            return i;
+        } else if (c < 0xe0) {
+            n = 1;
+            cp = c & 0x1f;
+        } else if (c < 0xf0) {
+            n = 2;
+            cp = c & 0x0f;
+        } else if (c < 0xf5) {
+            n = 3;
+            cp = c & 0x07;
+        } else {
+            return i;
+        }
+        if (len - i - 1 < n)
+            return i;
+        for (Size k = 1; k <= n; k++) {
+            UByte b = src[i + k];
+            if ((b & 0xc0) != 0x80)
+                return i;
+            cp = (cp << 6) | (b & 0x3f);
+        }
+        if (n == 2 && (cp < 0x800 || (cp >= 0xd800 && cp <= 0xdfff)))
+            return i;
+        if (n == 3 && (cp < 0x10000 || cp > 0x10ffff))
+            return i;
+        i += n + 1;
+    }
+    return i;
+}
+
+}  // namespace codec
+}  // namespace node
+}  // namespace libj
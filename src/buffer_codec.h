@@ -0,0 +1,46 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef SRC_BUFFER_CODEC_H_
+#define SRC_BUFFER_CODEC_H_
+
+#include <libj/typedef.h>
+
+namespace libj {
+namespace node {
+namespace codec {
+
+// the kernels below use SSE2, SSSE3 or AVX2 where the CPU has them,
+// chosen once at startup, and scalar code elsewhere
+
+Size base64EncodedLength(Size len);
+
+// writes base64EncodedLength(len) characters, padded with '=' unless
+// 'url' selects the URL-safe alphabet, which is left unpadded
+Size base64Encode(const UByte* src, Size len, char* dst, Boolean url);
+
+// the most bytes 'len' characters decode to
+Size base64DecodedLength(Size len);
+
+// accepts either alphabet, skips characters outside them, and stops at
+// '='. writes at most 'dstLen' bytes and returns how many it wrote.
+Size base64Decode(const char* src, Size len, UByte* dst, Size dstLen);
+
+// writes 2 * len lowercase hex digits
+void hexEncode(const UByte* src, Size len, char* dst);
+
+// decodes pairs of hex digits until an invalid one, and returns the
+// number of bytes written, at most len / 2
+Size hexDecode(const char* src, Size len, UByte* dst);
+
+Boolean isAscii(const UByte* src, Size len);
+
+// the length of the longest prefix which is valid UTF-8, that is,
+// without overlong forms, surrogates, code points above U+10FFFF or
+// truncated sequences
+Size validUtf8Prefix(const UByte* src, Size len);
+
+}  // namespace codec
+}  // namespace node
+}  // namespace libj
+
+#endif  // SRC_BUFFER_CODEC_H_
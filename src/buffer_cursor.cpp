@@ -0,0 +1,116 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <string>
+
+#include "libnode/buffer_cursor.h"
+
+namespace libj {
+namespace node {
+
+// a varint of a ULong takes at most 10 bytes
+static const Size kMaxVarintLength = 10;
+
+BufferWriter::BufferWriter(Size capacity)
+    : buffer_(LIBJ_NULL(Buffer))
+    , data_(0)
+    , length_(0)
+    , capacity_(0)
+    , initialCapacity_(capacity ? capacity : 1) {}
+
+void BufferWriter::grow(Size n) {
+    Size capacity = capacity_ ? capacity_ : initialCapacity_;
+    while (capacity - length_ < n)
+        capacity *= 2;
+
+    Buffer::Ptr buf = Buffer::create(capacity);
+    UByte* data = static_cast<UByte*>(const_cast<void*>(buf->data()));
+    if (length_)
+        memcpy(data, data_, length_);
+    buffer_ = buf;
+    data_ = data;
+    capacity_ = capacity;
+}
+
+void BufferWriter::writeLongVarint(ULong value) {
+    UByte* p = reserve(kMaxVarintLength);
+    Size n = 0;
+    while (value >= 0x80) {
+        p[n++] = static_cast<UByte>(value | 0x80);
+        value >>= 7;
+    }
+    p[n++] = static_cast<UByte>(value);
+    length_ += n;
+}
+
+void BufferWriter::writeString(String::CPtr str) {
+    if (!str) {
+        writeVarint(0);
+        return;
+    }
+
+    std::string s = str->toStdString();
+    writeVarint(s.length());
+    write(s.data(), s.length());
+}
+
+void BufferWriter::writeBuffer(Buffer::CPtr buf) {
+    Size len = buf ? buf->length() : 0;
+    writeVarint(len);
+    if (len)
+        write(buf->data(), len);
+}
+
+Buffer::Ptr BufferWriter::toBuffer() {
+    Buffer::Ptr buf = buffer_
+        ? buffer_->slice(0, length_)
+        : Buffer::create(static_cast<Size>(0));
+    buffer_ = LIBJ_NULL(Buffer);
+    data_ = 0;
+    length_ = 0;
+    capacity_ = 0;
+    return buf;
+}
+
+BufferReader::BufferReader(Buffer::CPtr buf)
+    : buffer_(buf)
+    , data_(buf ? static_cast<const UByte*>(buf->data()) : 0)
+    , length_(buf ? buf->length() : 0)
+    , position_(0)
+    , isValid_(true) {}
+
+ULong BufferReader::readLongVarint() {
+    ULong v = 0;
+    for (Size i = 0; i < kMaxVarintLength; i++) {
+        if (position_ == length_)
+            break;
+
+        UByte b = data_[position_++];
+        v |= static_cast<ULong>(b & 0x7f) << (7 * i);
+        if (!(b & 0x80))
+            return v;
+    }
+    fail();
+    return 0;
+}
+
+String::CPtr BufferReader::readString() {
+    Size len = readVarint();
+    const UByte* p = read(len);
+    if (!isValid_) {
+        LIBJ_NULL_CPTR(String, nullp);
+        return nullp;
+    }
+    return len ? String::create(p, String::UTF8, len) : String::create();
+}
+
+Buffer::Ptr BufferReader::readBuffer() {
+    Size len = readVarint();
+    Size start = position_;
+    read(len);
+    if (!isValid_)
+        return LIBJ_NULL(Buffer);
+    return buffer_->slice(start, start + len);
+}
+
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,175 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <string.h>
+#include <string>
+
+#include "libnode/buffer_list.h"
+#include "./buffer_search.h"
+
+namespace libj {
+namespace node {
+
+BufferList::BufferList()
+    : head_(0)
+    , length_(0) {}
+
+void BufferList::append(Buffer::CPtr buf) {
+    if (!buf || !buf->length())
+        return;
+
+    buffers_.push_back(buf);
+    length_ += buf->length();
+}
+
+void BufferList::append(String::CPtr str) {
+    if (str)
+        append(Buffer::create(str));
+}
+
+void BufferList::clear() {
+    buffers_.clear();
+    head_ = 0;
+    length_ = 0;
+}
+
+Buffer::Ptr BufferList::peek(Size n) const {
+    if (n > length_)
+        n = length_;
+    if (!n)
+        return Buffer::create(static_cast<Size>(0));
+
+    Buffer::CPtr first = buffers_.front();
+    if (n <= first->length() - head_)
+        return first->slice(head_, head_ + n);
+
+    Buffer::Ptr buf = Buffer::create(n);
+    copyTo(static_cast<UByte*>(const_cast<void*>(buf->data())), n);
+    return buf;
+}
+
+Buffer::Ptr BufferList::consume(Size n) {
+    Buffer::Ptr buf = peek(n);
+    skip(buf->length());
+    return buf;
+}
+
+void BufferList::skip(Size n) {
+    if (n > length_)
+        n = length_;
+    length_ -= n;
+    while (n) {
+        Size avail = buffers_.front()->length() - head_;
+        if (n < avail) {
+            head_ += n;
+            return;
+        }
+        n -= avail;
+        buffers_.pop_front();
+        head_ = 0;
+    }
+}
+
+Size BufferList::indexOf(UByte value, Size byteOffset) const {
+    return indexOfBytes(&value, 1, byteOffset);
+}
+
+Size BufferList::indexOf(String::CPtr value, Size byteOffset) const {
+    if (!value)
+        return NO_POS;
+
+    std::string s = value->toStdString();
+    return indexOfBytes(
+        reinterpret_cast<const UByte*>(s.data()), s.length(), byteOffset);
+}
+
+Size BufferList::indexOf(Buffer::CPtr value, Size byteOffset) const {
+    if (!value)
+        return NO_POS;
+
+    return indexOfBytes(
+        static_cast<const UByte*>(value->data()), value->length(), byteOffset);
+}
+
+Buffer::Ptr BufferList::flatten() {
+    if (buffers_.size() == 1)
+        return buffers_.front()->slice(head_);
+
+    Buffer::Ptr buf = peek(length_);
+    if (length_) {
+        buffers_.clear();
+        buffers_.push_back(buf);
+        head_ = 0;
+    }
+    return buf;
+}
+
+Size BufferList::indexOfBytes(
+    const UByte* needle, Size n, Size byteOffset) const {
+    if (byteOffset > length_ || n > length_ - byteOffset)
+        return NO_POS;
+    if (!n)
+        return byteOffset;
+
+    Size base = 0;
+    Size num = buffers_.size();
+    for (Size i = 0; i < num; i++) {
+        Size start = i ? 0 : head_;
+        const UByte* p = static_cast<const UByte*>(buffers_[i]->data());
+        p += start;
+        Size len = buffers_[i]->length() - start;
+        if (base + len <= byteOffset) {
+            base += len;
+            continue;
+        }
+
+        // matches within this Buffer, and then those which start in its
+        // last n - 1 bytes and go on into the next ones
+        Size from = byteOffset > base ? byteOffset - base : 0;
+        Size pos = search::indexOf(p + from, len - from, needle, n);
+        if (pos != NO_POS)
+            return base + from + pos;
+
+        if (i + 1 < num) {
+            Size k = len >= n ? len - n + 1 : 0;
+            if (k < from) k = from;
+            for (; k < len; k++) {
+                if (p[k] == needle[0] && matchesAt(i, start + k, needle, n))
+                    return base + k;
+            }
+        }
+        base += len;
+    }
+    return NO_POS;
+}
+
+Boolean BufferList::matchesAt(
+    Size index, Size offset, const UByte* s, Size n) const {
+    Size num = buffers_.size();
+    for (Size i = index; i < num && n; i++) {
+        const UByte* p = static_cast<const UByte*>(buffers_[i]->data());
+        Size len = buffers_[i]->length();
+        Size m = len - offset < n ? len - offset : n;
+        if (memcmp(p + offset, s, m))
+            return false;
+        s += m;
+        n -= m;
+        offset = 0;
+    }
+    return !n;
+}
+
+void BufferList::copyTo(UByte* dst, Size n) const {
+    Size offset = head_;
+    for (Size i = 0; n; i++) {
+        const UByte* p = static_cast<const UByte*>(buffers_[i]->data());
+        Size m = buffers_[i]->length() - offset;
+        if (m > n) m = n;
+        memcpy(dst, p + offset, m);
+        dst += m;
+        n -= m;
+        offset = 0;
+    }
+}
+
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,296 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+# define LIBNODE_SEARCH_X86
+# include <immintrin.h>
+#endif
+
+#include "./buffer_search.h"
+
+namespace libj {
+namespace node {
+namespace search {
+
+namespace {
+    // the kernels filter candidate positions by comparing the first and
+    // the last byte of the needle against two loads a block at a time,
+    // after W. Mula, "SIMD-friendly algorithms for substring searching",
+    // and compare the middle only where both match. they are given
+    // 1 <= n <= len, scan whole blocks from the start, or from the end,
+    // and leave the remaining positions to the scalar code through
+    // '*rest': the first one not scanned forwards, or one past the last
+    // one not scanned backwards. the scalar code does all of it where
+    // the CPU has no kernel, whose pointer in Kernels is then null.
+
+    inline Boolean matchesMiddle(
+        const UByte* src, const UByte* needle, Size n) {
+        return n <= 2 || !memcmp(src + 1, needle + 1, n - 2);
+    }
+
+#ifdef LIBNODE_SEARCH_X86
+    __attribute__((target("sse2")))
+    Size findSse2(
+        const UByte* src, Size len, const UByte* needle, Size n, Size* rest) {
+        const __m128i first = _mm_set1_epi8(needle[0]);
+        const __m128i last = _mm_set1_epi8(needle[n - 1]);
+        Size i = 0;
+        for (; i + n - 1 + 16 <= len; i += 16) {
+            __m128i f = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(src + i));
+            __m128i l = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(src + i + n - 1));
+            unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+                _mm_cmpeq_epi8(f, first), _mm_cmpeq_epi8(l, last)));
+            while (mask) {
+                Size pos = i + __builtin_ctz(mask);
+                if (matchesMiddle(src + pos, needle, n))
+                    return pos;
+                mask &= mask - 1;
+            }
+        }
+        *rest = i;
+        return NO_POS;
+    }
+
+    __attribute__((target("sse2")))
+    Size findLastSse2(
+        const UByte* src, Size len, const UByte* needle, Size n, Size* rest) {
+        const __m128i first = _mm_set1_epi8(needle[0]);
+        const __m128i last = _mm_set1_epi8(needle[n - 1]);
+        Size end = len - n + 1;
+        for (; end >= 16; end -= 16) {
+            Size i = end - 16;
+            __m128i f = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(src + i));
+            __m128i l = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(src + i + n - 1));
+            unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+                _mm_cmpeq_epi8(f, first), _mm_cmpeq_epi8(l, last)));
+            while (mask) {
+                unsigned bit = 31 - __builtin_clz(mask);
+                if (matchesMiddle(src + i + bit, needle, n))
+                    return i + bit;
+                mask &= ~(1u << bit);
+            }
+        }
+        *rest = end;
+        return NO_POS;
+    }
+
+    __attribute__((target("avx2")))
+    Size findAvx2(
+        const UByte* src, Size len, const UByte* needle, Size n, Size* rest) {
+        const __m256i first = _mm256_set1_epi8(needle[0]);
+        const __m256i last = _mm256_set1_epi8(needle[n - 1]);
+        Size i = 0;
+        for (; i + n - 1 + 32 <= len; i += 32) {
+            __m256i f = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(src + i));
+            __m256i l = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(src + i + n - 1));
+            unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(
+                _mm256_cmpeq_epi8(f, first), _mm256_cmpeq_epi8(l, last)));
+            while (mask) {
+                Size pos = i + __builtin_ctz(mask);
+                if (matchesMiddle(src + pos, needle, n))
+                    return pos;
+                mask &= mask - 1;
+            }
+        }
+        Size pos = findSse2(src + i, len - i, needle, n, rest);
+        *rest += i;
+        return pos == NO_POS ? NO_POS : i + pos;
+    }
+
+    __attribute__((target("avx2")))
+    Size findLastAvx2(
+        const UByte* src, Size len, const UByte* needle, Size n, Size* rest) {
+        const __m256i first = _mm256_set1_epi8(needle[0]);
+        const __m256i last = _mm256_set1_epi8(needle[n - 1]);
+        Size end = len - n + 1;
+        for (; end >= 32; end -= 32) {
+            Size i = end - 32;
+            __m256i f = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(src + i));
+            __m256i l = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(src + i + n - 1));
+            unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(
+                _mm256_cmpeq_epi8(f, first), _mm256_cmpeq_epi8(l, last)));
+            while (mask) {
+                unsigned bit = 31 - __builtin_clz(mask);
+                if (matchesMiddle(src + i + bit, needle, n))
+                    return i + bit;
+                mask &= ~(1u << bit);
+            }
+        }
+        return findLastSse2(src, end + n - 1, needle, n, rest);
+    }
+
+    // 'set' always has 4 bytes here, repeated if fewer were given
+
+    __attribute__((target("sse2")))
+    Size findAnySse2(const UByte* src, Size len, const UByte* set) {
+        const __m128i s0 = _mm_set1_epi8(set[0]);
+        const __m128i s1 = _mm_set1_epi8(set[1]);
+        const __m128i s2 = _mm_set1_epi8(set[2]);
+        const __m128i s3 = _mm_set1_epi8(set[3]);
+        Size i = 0;
+        for (; i + 16 <= len; i += 16) {
+            __m128i in = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(src + i));
+            __m128i eq = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(in, s0), _mm_cmpeq_epi8(in, s1)),
+                _mm_or_si128(_mm_cmpeq_epi8(in, s2), _mm_cmpeq_epi8(in, s3)));
+            unsigned mask = _mm_movemask_epi8(eq);
+            if (mask)
+                return i + __builtin_ctz(mask);
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    Size findAnyAvx2(const UByte* src, Size len, const UByte* set) {
+        const __m256i s0 = _mm256_set1_epi8(set[0]);
+        const __m256i s1 = _mm256_set1_epi8(set[1]);
+        const __m256i s2 = _mm256_set1_epi8(set[2]);
+        const __m256i s3 = _mm256_set1_epi8(set[3]);
+        Size i = 0;
+        for (; i + 32 <= len; i += 32) {
+            __m256i in = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(src + i));
+            __m256i eq = _mm256_or_si256(
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(in, s0), _mm256_cmpeq_epi8(in, s1)),
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(in, s2), _mm256_cmpeq_epi8(in, s3)));
+            unsigned mask = _mm256_movemask_epi8(eq);
+            if (mask)
+                return i + __builtin_ctz(mask);
+        }
+        return i + findAnySse2(src + i, len - i, set);
+    }
+#endif  // LIBNODE_SEARCH_X86
+
+    typedef Size (*Kernel)(const UByte*, Size, const UByte*, Size, Size*);
+
+    // the any kernels return where they found a byte of the set, or
+    // where they stopped scanning
+    typedef Size (*AnyKernel)(const UByte*, Size, const UByte*);
+
+    struct Kernels {
+        Kernel find;
+        Kernel findLast;
+        AnyKernel findAny;
+
+        Kernels()
+            : find(0)
+            , findLast(0)
+            , findAny(0) {
+#ifdef LIBNODE_SEARCH_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("sse2")) {
+                find = findSse2;
+                findLast = findLastSse2;
+                findAny = findAnySse2;
+            }
+            if (__builtin_cpu_supports("avx2")) {
+                find = findAvx2;
+                findLast = findLastAvx2;
+                findAny = findAnyAvx2;
+            }
+#endif
+        }
+    };
+
+    const Kernels& kernels() {
+        static const Kernels k;
+        return k;
+    }
+}
+
+Size indexOf(const UByte* src, Size len, UByte c) {
+    const void* p = memchr(src, c, len);
+    return p ? static_cast<const UByte*>(p) - src : NO_POS;
+}
+
+Size indexOf(const UByte* src, Size len, const UByte* needle, Size n) {
+    if (!n)
+        return 0;
+    if (n > len)
+        return NO_POS;
+    if (n == 1)
+        return indexOf(src, len, needle[0]);
+
+    const Kernels& k = kernels();
+    Size i = 0;
+    if (k.find) {
+        Size pos = k.find(src, len, needle, n, &i);
+        if (pos != NO_POS)
+            return pos;
+    }
+
+    // memchr finds the candidates for the rest
+    Size last = len - n;
+    while (i <= last) {
+        const void* p = memchr(src + i, needle[0], last - i + 1);
+        if (!p)
+            break;
+        i = static_cast<const UByte*>(p) - src;
+        if (src[i + n - 1] == needle[n - 1] &&
+            matchesMiddle(src + i, needle, n))
+            return i;
+        i++;
+    }
+    return NO_POS;
+}
+
+Size lastIndexOf(const UByte* src, Size len, UByte c) {
+    return lastIndexOf(src, len, &c, 1);
+}
+
+Size lastIndexOf(const UByte* src, Size len, const UByte* needle, Size n) {
+    if (!n)
+        return len;
+    if (n > len)
+        return NO_POS;
+
+    const Kernels& k = kernels();
+    Size end = len - n + 1;
+    if (k.findLast) {
+        Size pos = k.findLast(src, len, needle, n, &end);
+        if (pos != NO_POS)
+            return pos;
+    }
+
+    while (end--) {
+        if (src[end] == needle[0] &&
+            src[end + n - 1] == needle[n - 1] &&
+            matchesMiddle(src + end, needle, n))
+            return end;
+    }
+    return NO_POS;
+}
+
+Size indexOfAny(const UByte* src, Size len, const UByte* set, Size n) {
+    if (n == 1)
+        return indexOf(src, len, set[0]);
+
+    UByte s[4];
+    for (Size k = 0; k < 4; k++)
+        s[k] = set[k < n ? k : 0];
+
+    const Kernels& k = kernels();
+    Size i = k.findAny ? k.findAny(src, len, s) : 0;
+    for (; i < len; i++) {
+        UByte c = src[i];
+        if (c == s[0] || c == s[1] || c == s[2] || c == s[3])
+            return i;
+    }
+    return NO_POS;
+}
+
+}  // namespace search
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,32 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef SRC_BUFFER_SEARCH_H_
+#define SRC_BUFFER_SEARCH_H_
+
+#include <libj/typedef.h>
+
+namespace libj {
+namespace node {
+namespace search {
+
+// byte string search over raw memory, using SSE2 or AVX2 where the CPU
+// has them, chosen once at startup. each returns the position of the
+// match, or NO_POS. an empty needle matches at the start, or the end.
+
+Size indexOf(const UByte* src, Size len, UByte c);
+
+Size indexOf(const UByte* src, Size len, const UByte* needle, Size n);
+
+Size lastIndexOf(const UByte* src, Size len, UByte c);
+
+Size lastIndexOf(const UByte* src, Size len, const UByte* needle, Size n);
+
+// the position of the first byte which is one of the 'n' bytes of 'set',
+// where n is 1 to 4, or NO_POS
+Size indexOfAny(const UByte* src, Size len, const UByte* set, Size n);
+
+}  // namespace search
+}  // namespace node
+}  // namespace libj
+
+#endif  // SRC_BUFFER_SEARCH_H_
@@ -0,0 +1,148 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef SRC_BUFFER_VIEW_H_
+#define SRC_BUFFER_VIEW_H_
+
+#include <libj/js_object.h>
+#include <string.h>
+
+#include "libnode/buffer.h"
+
+namespace libj {
+namespace node {
+
+// a Buffer over memory it does not allocate. the memory stays valid as
+// long as 'owner' is alive, which its slices keep alive in turn.
+class BufferView : public Buffer {
+ public:
+    BufferView(
+        const void* data,
+        Size length,
+        Boolean isReadOnly,
+        JsArrayBuffer::CPtr owner)
+        : data_(static_cast<UByte*>(const_cast<void*>(data)))
+        , length_(length)
+        , isReadOnly_(isReadOnly)
+        , owner_(owner)
+        , obj_(LIBJ_NULL(JsObject)) {}
+
+    Size length() const {
+        return length_;
+    }
+
+    const void* data() const {
+        return data_;
+    }
+
+    Boolean isReadOnly() const {
+        return isReadOnly_;
+    }
+
+    Ptr slice(Size start, Size end) const {
+        if (end > length_) end = length_;
+        if (start > end) start = end;
+        Size len = end - start;
+        Ptr p(new BufferView(data_ + start, len, isReadOnly_, owner_));
+        return p;
+    }
+
+    void write(
+        String::CPtr str,
+        Size offset,
+        Size length,
+        String::Encoding enc) {
+        if (isReadOnly_ || !str || offset >= length_)
+            return;
+
+        Buffer::CPtr b = Buffer::create(str, enc);
+        Size n = length_ - offset;
+        if (length < n) n = length;
+        if (b->length() < n) n = b->length();
+        memcpy(data_ + offset, b->data(), n);
+    }
+
+    Boolean getInt8(Size offset, Byte* value) const {
+        return getValue(offset, value, false);
+    }
+
+    Boolean setInt8(Size offset, Byte value) {
+        return setValue(offset, value, false);
+    }
+
+    Boolean getUInt8(Size offset, UByte* value) const {
+        return getValue(offset, value, false);
+    }
+
+    Boolean setUInt8(Size offset, UByte value) {
+        return setValue(offset, value, false);
+    }
+
+#define LIBNODE_BUFFER_VIEW_ACCESSORS(N, T) \
+    Boolean get##N(Size offset, T* value, Boolean le = false) const { \
+        return getValue(offset, value, le); \
+    } \
+    Boolean set##N(Size offset, T value, Boolean le = false) { \
+        return setValue(offset, value, le); \
+    }
+
+    LIBNODE_BUFFER_VIEW_ACCESSORS(Int16, Short)
+    LIBNODE_BUFFER_VIEW_ACCESSORS(UInt16, UShort)
+    LIBNODE_BUFFER_VIEW_ACCESSORS(Int32, Int)
+    LIBNODE_BUFFER_VIEW_ACCESSORS(UInt32, UInt)
+    LIBNODE_BUFFER_VIEW_ACCESSORS(Float32, Float)
+    LIBNODE_BUFFER_VIEW_ACCESSORS(Float64, Double)
+
+#undef LIBNODE_BUFFER_VIEW_ACCESSORS
+
+ private:
+    static Boolean isHostLittleEndian() {
+        static const UShort one = 1;
+        return *reinterpret_cast<const UByte*>(&one) == 1;
+    }
+
+    template<typename T>
+    Boolean getValue(Size offset, T* value, Boolean littleEndian) const {
+        if (!value || offset > length_ || sizeof(T) > length_ - offset)
+            return false;
+
+        UByte bytes[sizeof(T)];
+        Boolean swap = littleEndian != isHostLittleEndian();
+        for (Size i = 0; i < sizeof(T); i++)
+            bytes[i] = data_[offset + (swap ? sizeof(T) - 1 - i : i)];
+        memcpy(value, bytes, sizeof(T));
+        return true;
+    }
+
+    template<typename T>
+    Boolean setValue(Size offset, T value, Boolean littleEndian) {
+        if (isReadOnly_ || offset > length_ || sizeof(T) > length_ - offset)
+            return false;
+
+        UByte bytes[sizeof(T)];
+        memcpy(bytes, &value, sizeof(T));
+        Boolean swap = littleEndian != isHostLittleEndian();
+        for (Size i = 0; i < sizeof(T); i++)
+            data_[offset + (swap ? sizeof(T) - 1 - i : i)] = bytes[i];
+        return true;
+    }
+
+    UByte* data_;
+    Size length_;
+    Boolean isReadOnly_;
+    JsArrayBuffer::CPtr owner_;
+    mutable JsObject::Ptr obj_;
+
+    JsObject::Ptr object() const {
+        if (!obj_)
+            obj_ = JsObject::create();
+        return obj_;
+    }
+
+ public:
+    LIBJ_JS_OBJECT_IMPL(object());
+};
+
+}  // namespace node
+}  // namespace libj
+
+#endif  // SRC_BUFFER_VIEW_H_
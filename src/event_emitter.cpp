@@ -1,6 +1,7 @@
 // Copyright (c) 2012 Plenluno All rights reserved.
 
-#include <libj/null.h>
+#include <map>
+#include <vector>
 
 #include "libnode/event_emitter.h"
 
@@ -8,58 +9,262 @@ namespace libj {
 namespace node {
 namespace events {
 
+struct StringLess {
+    bool operator()(String::CPtr lhs, String::CPtr rhs) const {
+        return lhs->compareTo(rhs) < 0;
+    }
+};
+
+typedef std::map<String::CPtr, EventEmitter::EventId, StringLess> EventIds;
+
+// function-local statics, as event names are interned during static
+// initialization of other translation units
+static EventIds& eventIds() {
+    static EventIds ids;
+    return ids;
+}
+
+static std::vector<String::CPtr>& eventNames() {
+    static std::vector<String::CPtr> names;
+    return names;
+}
+
+EventEmitter::EventId EventEmitter::intern(String::CPtr event) {
+    EventIds& ids = eventIds();
+    EventIds::const_iterator itr = ids.find(event);
+    if (itr != ids.end())
+        return itr->second;
+
+    std::vector<String::CPtr>& names = eventNames();
+    EventId id = names.size();
+    names.push_back(event);
+    ids[event] = id;
+    return id;
+}
+
+// the id of an event already interned, or NO_POS, for the lookups which
+// must not grow the table with names that may come from untrusted input
+static EventEmitter::EventId findEvent(String::CPtr event) {
+    const EventIds& ids = eventIds();
+    EventIds::const_iterator itr = ids.find(event);
+    return itr != ids.end() ? itr->second : NO_POS;
+}
+
+String::CPtr EventEmitter::eventName(EventId event) {
+    std::vector<String::CPtr>& names = eventNames();
+    if (event < names.size()) {
+        return names[event];
+    } else {
+        LIBJ_NULL_CPTR(String, nullp);
+        return nullp;
+    }
+}
+
+// listeners run synchronously, so the arguments arrays of the typed
+// emits are pooled per nesting level and reused once the call returns
+class EmitArgs {
+ public:
+    EmitArgs() {
+        std::vector<JsArray::Ptr>& p = pool();
+        if (depth() == p.size())
+            p.push_back(JsArray::create());
+        args_ = p[depth()++];
+    }
+
+    ~EmitArgs() {
+        args_->clear();
+        depth()--;
+    }
+
+    JsArray::Ptr get() const { return args_; }
+
+ private:
+    JsArray::Ptr args_;
+
+    static std::vector<JsArray::Ptr>& pool() {
+        static std::vector<JsArray::Ptr> arrays;
+        return arrays;
+    }
+
+    static Size& depth() {
+        static Size d = 0;
+        return d;
+    }
+};
+
 class EventEmitterImpl : public EventEmitter {
  public:
     void on(String::CPtr event, JsFunction::Ptr listener) {
-        addListener(event, listener);
+        addListener(intern(event), listener);
     }
 
     void addListener(String::CPtr event, JsFunction::Ptr listener) {
-        JsArray::Ptr a;
-        Value v = listeners_->get(event);
-        if (v.instanceof(Type<Null>::id())) {
-            a = JsArray::create();
-            listeners_->put(event, a);
-        } else {
-            a = toPtr<JsArray>(v);
-        }
-        a->add(listener);
+        addListener(intern(event), listener);
     }
 
     void removeListener(String::CPtr event, JsFunction::CPtr listener) {
-        Value v = listeners_->get(event);
-        if (!v.instanceof(Type<Null>::id())) {
-            JsArray::Ptr a = toPtr<JsArray>(v);
-            while (a->remove(listener)) {}
-        }
+        removeListener(findEvent(event), listener);
     }
 
     void removeAllListeners() {
-        listeners_->clear();
+        if (depth_) {
+            for (Size i = 0; i < entries_.size(); i++)
+                clear(&entries_[i].listeners);
+        } else {
+            std::vector<Entry>().swap(entries_);
+        }
     }
 
     void removeAllListeners(String::CPtr event) {
-        Value v = listeners_->get(event);
-        if (!v.instanceof(Type<Null>::id())) {
-            JsArray::Ptr a = toPtr<JsArray>(v);
-            a->clear();
-        }
+        removeAllListeners(findEvent(event));
     }
 
     void emit(String::CPtr event, JsArray::Ptr args) {
-        Value v = listeners_->get(event);
-        if (!v.instanceof(Type<Null>::id())) {
-            JsArray::Ptr a = toPtr<JsArray>(v);
-            Size n = a->size();
-            for (Size i = 0; i < n; i++) {
-                JsFunction::Ptr f = toPtr<JsFunction>(a->get(i));
-                (*f)(args);
+        emit(findEvent(event), args);
+    }
+
+    Value listeners(String::CPtr event) {
+        return listeners(findEvent(event));
+    }
+
+    void on(EventId event, JsFunction::Ptr listener) {
+        addListener(event, listener);
+    }
+
+    void addListener(EventId event, JsFunction::Ptr listener) {
+        if (!listener)
+            return;
+        Size i = find(event);
+        if (i == NO_POS) {
+            i = entries_.size();
+            entries_.push_back(Entry());
+            entries_[i].event = event;
+        }
+        entries_[i].listeners.push_back(listener);
+    }
+
+    void removeListener(EventId event, JsFunction::CPtr listener) {
+        Size i = find(event);
+        if (i == NO_POS)
+            return;
+        Listeners& ls = entries_[i].listeners;
+        if (depth_) {
+            for (Size j = 0; j < ls.size(); j++) {
+                if (ls[j] == listener) {
+                    ls[j] = LIBJ_NULL(JsFunction);
+                    hasCleared_ = true;
+                }
+            }
+            return;
+        }
+
+        Size j = 0;
+        while (j < ls.size()) {
+            if (ls[j] == listener) {
+                ls.erase(ls.begin() + j);
+            } else {
+                j++;
             }
         }
+        if (ls.empty())
+            entries_.erase(entries_.begin() + i);
     }
 
-    Value listeners(String::CPtr event) {
-        return listeners_->get(event);
+    void removeAllListeners(EventId event) {
+        Size i = find(event);
+        if (i == NO_POS)
+            return;
+        if (depth_) {
+            clear(&entries_[i].listeners);
+        } else {
+            entries_.erase(entries_.begin() + i);
+        }
+    }
+
+    void emit(EventId event, JsArray::Ptr args) {
+        Size i = find(event);
+        if (i == NO_POS)
+            return;
+
+        // only the listeners registered when the emit starts are called.
+        // as those removed meanwhile are just cleared until the outermost
+        // emit returns, the lists neither shrink nor get reordered while
+        // they are walked, and need no copy.
+        Size n = entries_[i].listeners.size();
+        depth_++;
+        for (Size j = 0; j < n; j++) {
+            JsFunction::Ptr f = entries_[i].listeners[j];
+            if (f)
+                (*f)(args);
+        }
+        if (!--depth_ && hasCleared_)
+            compact();
+    }
+
+    Size listenerCount(EventId event) const {
+        Size i = find(event);
+        if (i == NO_POS)
+            return 0;
+        const Listeners& ls = entries_[i].listeners;
+        if (!hasCleared_)
+            return ls.size();
+        Size n = 0;
+        for (Size j = 0; j < ls.size(); j++) {
+            if (ls[j])
+                n++;
+        }
+        return n;
+    }
+
+    void emit(EventId event) {
+        if (!listenerCount(event))
+            return;
+        EmitArgs args;
+        emit(event, args.get());
+    }
+
+    void emit(EventId event, const Value& arg0) {
+        if (!listenerCount(event))
+            return;
+        EmitArgs args;
+        args.get()->add(arg0);
+        emit(event, args.get());
+    }
+
+    void emit(EventId event, const Value& arg0, const Value& arg1) {
+        if (!listenerCount(event))
+            return;
+        EmitArgs args;
+        args.get()->add(arg0);
+        args.get()->add(arg1);
+        emit(event, args.get());
+    }
+
+    void emit(
+        EventId event,
+        const Value& arg0,
+        const Value& arg1,
+        const Value& arg2) {
+        if (!listenerCount(event))
+            return;
+        EmitArgs args;
+        args.get()->add(arg0);
+        args.get()->add(arg1);
+        args.get()->add(arg2);
+        emit(event, args.get());
+    }
+
+    Value listeners(EventId event) {
+        JsArray::Ptr a = JsArray::create();
+        Size i = find(event);
+        if (i != NO_POS) {
+            const Listeners& ls = entries_[i].listeners;
+            for (Size j = 0; j < ls.size(); j++) {
+                if (ls[j])
+                    a->add(ls[j]);
+            }
+        }
+        return a;
     }
 
     static Ptr create() {
@@ -68,12 +273,71 @@ class EventEmitterImpl : public EventEmitter {
     }
 
  private:
-    JsObject::Ptr listeners_;
+    typedef std::vector<JsFunction::Ptr> Listeners;
+
+    struct Entry {
+        EventId event;
+        Listeners listeners;
+    };
+
+    // both the listener lists and the property map are created on first
+    // use, as most emitters (sockets, requests, responses) never get
+    // a listener and many never get a property. an emitter listens to a
+    // few events at most, so the lists are kept only for those, and
+    // searched linearly, rather than indexed by the global event id.
+    std::vector<Entry> entries_;
+    mutable JsObject::Ptr obj_;
+
+    // the number of emits running, while which listeners removed are
+    // only cleared, and the cleared ones are dropped afterwards
+    Size depth_;
+    Boolean hasCleared_;
 
     EventEmitterImpl()
-        : listeners_(JsObject::create()) {}
+        : obj_(LIBJ_NULL(JsObject))
+        , depth_(0)
+        , hasCleared_(false) {}
+
+    void clear(Listeners* ls) {
+        for (Size j = 0; j < ls->size(); j++)
+            (*ls)[j] = LIBJ_NULL(JsFunction);
+        hasCleared_ = true;
+    }
+
+    void compact() {
+        hasCleared_ = false;
+        Size i = 0;
+        while (i < entries_.size()) {
+            Listeners& ls = entries_[i].listeners;
+            Size k = 0;
+            for (Size j = 0; j < ls.size(); j++) {
+                if (ls[j])
+                    ls[k++] = ls[j];
+            }
+            ls.resize(k);
+            if (ls.empty()) {
+                entries_.erase(entries_.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+
+    Size find(EventId event) const {
+        for (Size i = 0; i < entries_.size(); i++) {
+            if (entries_[i].event == event)
+                return i;
+        }
+        return NO_POS;
+    }
+
+    JsObject::Ptr object() const {
+        if (!obj_)
+            obj_ = JsObject::create();
+        return obj_;
+    }
 
-    LIBJ_JS_OBJECT_IMPL(listeners_);
+    LIBJ_JS_OBJECT_IMPL(object());
 };
 
 EventEmitter::Ptr EventEmitter::create() {
@@ -1,129 +1,325 @@
 // Copyright (c) 2012 Plenluno All rights reserved.
 
+#include <errno.h>
 #include <fcntl.h>
 #include <libj/js_array.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <uv.h>
 #include <string>
+#include <vector>
 
 #include "libnode/file_system.h"
+#include "./fs_options.h"
+#include "./fs_read_cache.h"
+#ifdef LIBNODE_USE_IO_URING
+# include "./fs_uring.h"
+#endif
+#include "./tick_queue.h"
 
 namespace libj {
 namespace node {
 namespace fs {
 
+// regular files are read straight into a Buffer of their size, with as
+// few reads as the kernel allows. files of unknown size (e.g. in /proc)
+// are read in chunks of this size and copied into a Buffer at the end.
+static const Size kChunkLen = 64 * 1024;
+
+// keeps a single read within what read(2) transfers in one call
+static const Size kMaxReadLen = 1 << 30;
+
 struct FileReadContext {
+    uv_fs_t req;
     uv_file file;
     std::string path;
-    static const int kLen = 4096;
-    char buf[kLen];
-    std::string res;
-    Function::Ptr cb;
+    Buffer::Ptr buffer;
+    Size size;
+    Size offset;
+    std::vector<char> chunks;
+    int errorno;
+    Boolean hasEncoding;
+    String::Encoding enc;
+    JsFunction::Ptr cb;
 };
 
-static void onFileReadError(uv_fs_t* req) {
-    FileReadContext* context = static_cast<FileReadContext*>(req->data);
+static char* bufferData(Buffer::Ptr buffer) {
+    return static_cast<char*>(const_cast<void*>(buffer->data()));
+}
+
+static void readFileFinish(FileReadContext* context) {
     if (context->cb) {
         JsArray::Ptr args = JsArray::create();
-        args->add(req->errorno);
+        args->add(context->errorno);
+        if (!context->errorno) {
+            if (context->hasEncoding) {
+                args->add(String::create(
+                    context->buffer->data(),
+                    context->enc,
+                    context->buffer->length()));
+            } else {
+                args->add(context->buffer);
+            }
+        }
         (*(context->cb))(args);
     }
-    uv_fs_req_cleanup(req);
     delete context;
-    delete req;
 }
 
 static void afterFileClose(uv_fs_t* req) {
-    if (req->errorno) {
-        onFileReadError(req);
-    } else {
-        FileReadContext* context = static_cast<FileReadContext*>(req->data);
-        uv_fs_req_cleanup(req);
-        delete context;
-        delete req;
+    FileReadContext* context = static_cast<FileReadContext*>(req->data);
+    if (req->errorno && !context->errorno)
+        context->errorno = req->errorno;
+    uv_fs_req_cleanup(req);
+    readFileFinish(context);
+    process::runTickQueue();
+}
+
+static void closeFile(FileReadContext* context) {
+    uv_fs_t* req = &context->req;
+    int err = uv_fs_close(
+        uv_default_loop(),
+        req,
+        context->file,
+        afterFileClose);
+    if (err) {
+        req->errorno = err;
+        afterFileClose(req);
     }
 }
 
-static void readFileData(uv_fs_t* req, FileReadContext* context);
+static void afterFileRead(uv_fs_t* req);
+
+static void readFileData(FileReadContext* context) {
+    uv_fs_t* req = &context->req;
+    char* buf;
+    Size len;
+    if (context->buffer) {
+        buf = bufferData(context->buffer) + context->offset;
+        len = context->size - context->offset;
+        if (len > kMaxReadLen)
+            len = kMaxReadLen;
+    } else {
+        context->chunks.resize(context->offset + kChunkLen);
+        buf = &context->chunks[context->offset];
+        len = kChunkLen;
+    }
+    int err = uv_fs_read(
+        uv_default_loop(),
+        req,
+        context->file,
+        buf,
+        len,
+        context->offset,
+        afterFileRead);
+    if (err) {
+        context->errorno = err;
+        closeFile(context);
+    }
+}
 
 static void afterFileRead(uv_fs_t* req) {
+    FileReadContext* context = static_cast<FileReadContext*>(req->data);
+    ssize_t nread = req->result;
     if (req->errorno) {
-        onFileReadError(req);
-    } else if (req->result) {
-        FileReadContext* context = static_cast<FileReadContext*>(req->data);
-        context->res.append(std::string(context->buf, context->kLen));
-        readFileData(req, context);
+        context->errorno = req->errorno;
+        uv_fs_req_cleanup(req);
+        closeFile(context);
+        process::runTickQueue();
+        return;
+    }
+    uv_fs_req_cleanup(req);
+
+    context->offset += nread;
+    if (nread && (!context->buffer || context->offset < context->size)) {
+        readFileData(context);
     } else {
-        FileReadContext* context = static_cast<FileReadContext*>(req->data);
-        if (context->cb) {
-            JsArray::Ptr args = JsArray::create();
-            args->add(req->errorno);
-            args->add(String::create(context->res.c_str()));
-            (*(context->cb))(args);
+        // the file may have been shrunk since its size was taken
+        if (!context->buffer || context->offset < context->size) {
+            Buffer::Ptr buffer = Buffer::create(context->offset);
+            const char* src = context->buffer
+                ? bufferData(context->buffer)
+                : (context->offset ? &context->chunks[0] : 0);
+            if (context->offset)
+                memcpy(bufferData(buffer), src, context->offset);
+            context->buffer = buffer;
+            std::vector<char>().swap(context->chunks);
         }
+        closeFile(context);
+    }
+    process::runTickQueue();
+}
+
+static void afterFileStat(uv_fs_t* req) {
+    FileReadContext* context = static_cast<FileReadContext*>(req->data);
+    if (req->errorno) {
+        context->errorno = req->errorno;
+        uv_fs_req_cleanup(req);
+        closeFile(context);
+    } else {
+        struct stat* s = static_cast<struct stat*>(req->ptr);
+        if (S_ISREG(s->st_mode) && s->st_size > 0) {
+            context->size = s->st_size;
+            context->buffer = Buffer::create(context->size);
+        }
+        uv_fs_req_cleanup(req);
+        readFileData(context);
+    }
+    process::runTickQueue();
+}
+
+static void afterFileOpen(uv_fs_t* req) {
+    FileReadContext* context = static_cast<FileReadContext*>(req->data);
+    if (req->errorno) {
+        context->errorno = req->errorno;
+        uv_fs_req_cleanup(req);
+        readFileFinish(context);
+    } else {
+        context->file = req->result;
         uv_fs_req_cleanup(req);
-        req->data = context;
-        int err = uv_fs_close(
+        int err = uv_fs_fstat(
             uv_default_loop(),
             req,
             context->file,
-            afterFileClose);
+            afterFileStat);
         if (err) {
-            req->errorno = err;
-            onFileReadError(req);
+            context->errorno = err;
+            closeFile(context);
         }
     }
+    process::runTickQueue();
 }
 
-static void readFileData(uv_fs_t* req, FileReadContext* context) {
-    if (context->res.length())
-        uv_fs_req_cleanup(req);
+static void openFile(FileReadContext* context) {
+    uv_fs_t* req = &context->req;
+    req->errorno = 0;
     req->data = context;
-    int err = uv_fs_read(
+    int err = uv_fs_open(
         uv_default_loop(),
         req,
-        context->file,
-        context->buf,
-        context->kLen,
-        context->res.length(),
-        afterFileRead);
+        context->path.c_str(),
+        O_RDONLY,
+        438,
+        afterFileOpen);
     if (err) {
-        req->errorno = err;
-        onFileReadError(req);
+        context->errorno = err;
+        readFileFinish(context);
     }
 }
 
-static void readFileAfterOpen(uv_fs_t* req) {
-    if (req->errorno) {
-        onFileReadError(req);
+#ifdef LIBNODE_USE_IO_URING
+static void afterUringRead(void* data, int err, Buffer::Ptr buffer) {
+    FileReadContext* context = static_cast<FileReadContext*>(data);
+    if (err || buffer) {
+        context->errorno = err;
+        context->buffer = buffer;
+        readFileFinish(context);
     } else {
-        FileReadContext* context = static_cast<FileReadContext*>(req->data);
-        context->file = req->result;
-        readFileData(req, context);
+        openFile(context);
     }
 }
+#endif
 
-void readFile(
-    String::CPtr fileName,
+static void readFile(
+    const std::string& path,
+    Boolean hasEncoding,
+    String::Encoding enc,
     JsFunction::Ptr callback) {
     FileReadContext* context = new FileReadContext;
+    context->path = path;
+    context->buffer = LIBJ_NULL(Buffer);
+    context->size = 0;
+    context->offset = 0;
+    context->errorno = 0;
+    context->hasEncoding = hasEncoding;
+    context->enc = enc;
     context->cb = callback;
-    context->path = fileName->toStdString();
-    uv_fs_t* req = new uv_fs_t;
-    req->errorno = 0;
-    req->data = context;
-    int err = uv_fs_open(
-        uv_default_loop(),
-        req,
-        context->path.c_str(),
-        O_RDONLY,
-        438,
-        readFileAfterOpen);
-    if (err) {
-        req->errorno = err;
-        onFileReadError(req);
+#ifdef LIBNODE_USE_IO_URING
+    if (uring::readFile(context->path.c_str(), afterUringRead, context))
+        return;
+#endif
+    openFile(context);
+}
+
+void readFileUncached(const std::string& path, JsFunction::Ptr callback) {
+    readFile(path, false, String::UTF8, callback);
+}
+
+static void readFile(
+    String::CPtr fileName,
+    Boolean hasEncoding,
+    String::Encoding enc,
+    JsFunction::Ptr callback) {
+    std::string path = fileName->toStdString();
+    if (!readFileCached(path, hasEncoding, enc, callback))
+        readFile(path, hasEncoding, enc, callback);
+}
+
+int toErrorCode(int err) {
+    switch (err) {
+    case 0:
+        return 0;
+    case EACCES:
+        return UV_EACCES;
+    case EBADF:
+        return UV_EBADF;
+    case EINVAL:
+        return UV_EINVAL;
+    case EIO:
+        return UV_EIO;
+    case EISDIR:
+        return UV_EISDIR;
+    case EMFILE:
+        return UV_EMFILE;
+    case ENOENT:
+        return UV_ENOENT;
+    case ENOMEM:
+        return UV_ENOMEM;
+    case ENOSPC:
+        return UV_ENOSPC;
+    default:
+        return UV_UNKNOWN;
     }
 }
 
+Size getSizeOption(JsObject::CPtr options, String::CPtr name, Size def) {
+    if (!options)
+        return def;
+
+    Value v = options->get(name);
+    Long l;
+    Int i;
+    if (to<Long>(v, &l) && l >= 0) {
+        return static_cast<Size>(l);
+    } else if (to<Int>(v, &i) && i >= 0) {
+        return static_cast<Size>(i);
+    } else {
+        return def;
+    }
+}
+
+String::CPtr getStringOption(
+    JsObject::CPtr options, String::CPtr name, String::CPtr def) {
+    if (!options)
+        return def;
+
+    String::CPtr s = options->getCPtr<String>(name);
+    return s ? s : def;
+}
+
+void readFile(
+    String::CPtr fileName,
+    JsFunction::Ptr callback) {
+    readFile(fileName, false, String::UTF8, callback);
+}
+
+void readFile(
+    String::CPtr fileName,
+    String::Encoding enc,
+    JsFunction::Ptr callback) {
+    readFile(fileName, true, enc, callback);
+}
+
 }  // namespace fs
 }  // namespace node
 }  // namespace libj
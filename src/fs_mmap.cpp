@@ -0,0 +1,95 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+
+#include "libnode/file_system.h"
+#include "./buffer_view.h"
+#include "./fs_options.h"
+
+namespace libj {
+namespace node {
+namespace fs {
+
+const String::CPtr ADVICE = String::create("advice");
+const String::CPtr ADVICE_NORMAL = String::create("normal");
+const String::CPtr ADVICE_SEQUENTIAL = String::create("sequential");
+const String::CPtr ADVICE_RANDOM = String::create("random");
+const String::CPtr ADVICE_WILLNEED = String::create("willneed");
+
+// owns the mapping, which is unmapped when the last view of it is gone
+class MappedBuffer : public BufferView {
+ public:
+    MappedBuffer(void* addr, Size length)
+        : BufferView(addr, length, true, LIBJ_NULL(JsArrayBuffer))
+        , addr_(addr)
+        , mapLength_(length) {}
+
+    virtual ~MappedBuffer() {
+        munmap(addr_, mapLength_);
+    }
+
+ private:
+    void* addr_;
+    Size mapLength_;
+};
+
+static int toAdvice(String::CPtr advice) {
+    if (advice->compareTo(ADVICE_SEQUENTIAL) == 0) {
+        return MADV_SEQUENTIAL;
+    } else if (advice->compareTo(ADVICE_RANDOM) == 0) {
+        return MADV_RANDOM;
+    } else if (advice->compareTo(ADVICE_WILLNEED) == 0) {
+        return MADV_WILLNEED;
+    } else {
+        return MADV_NORMAL;
+    }
+}
+
+Buffer::CPtr mmap(String::CPtr path) {
+    LIBJ_NULL_CPTR(JsObject, nullp);
+    return mmap(path, nullp);
+}
+
+Buffer::CPtr mmap(String::CPtr path, JsObject::CPtr options) {
+    LIBJ_NULL_CPTR(Buffer, nullp);
+    if (!path)
+        return nullp;
+
+    std::string p = path->toStdString();
+    int fd = open(p.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullp;
+
+    struct stat st;
+    if (fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return nullp;
+    }
+
+    Size length = static_cast<Size>(st.st_size);
+    if (!length) {
+        close(fd);
+        return Buffer::create(0);
+    }
+
+    // the mapping keeps the file referenced after its fd is closed
+    void* addr = ::mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return nullp;
+
+    String::CPtr advice = getStringOption(options, ADVICE, ADVICE_NORMAL);
+    madvise(addr, length, toAdvice(advice));
+
+    Buffer::CPtr mapping(new MappedBuffer(addr, length));
+    Buffer::CPtr buf(new BufferView(addr, length, true, mapping));
+    return buf;
+}
+
+}  // namespace fs
+}  // namespace node
+}  // namespace libj
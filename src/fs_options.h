@@ -0,0 +1,26 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef SRC_FS_OPTIONS_H_
+#define SRC_FS_OPTIONS_H_
+
+#include <libj/js_object.h>
+
+namespace libj {
+namespace node {
+namespace fs {
+
+// the non-negative integer option 'name', or 'def' if absent or invalid
+Size getSizeOption(JsObject::CPtr options, String::CPtr name, Size def);
+
+// the string option 'name', or 'def' if absent
+String::CPtr getStringOption(
+    JsObject::CPtr options, String::CPtr name, String::CPtr def);
+
+// the libuv error code of errno 'err'
+int toErrorCode(int err);
+
+}  // namespace fs
+}  // namespace node
+}  // namespace libj
+
+#endif  // SRC_FS_OPTIONS_H_
@@ -0,0 +1,217 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <libj/js_array.h>
+#include <uv.h>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "libnode/file_system.h"
+#include "libnode/process.h"
+#include "./buffer_view.h"
+#include "./fs_read_cache.h"
+
+namespace libj {
+namespace node {
+namespace fs {
+
+namespace {
+    // contents are kept by path, each file watched for changes while it
+    // is cached or being read, and are handed out as read-only views.
+    // reads of a path being read wait for that read instead of starting
+    // their own. a file that changes while being read is delivered to
+    // those waiting but not cached.
+
+    struct Waiter {
+        Boolean hasEncoding;
+        String::Encoding enc;
+        JsFunction::Ptr callback;
+    };
+
+    struct Entry {
+        std::string path;
+        Buffer::CPtr content;
+        std::vector<Waiter> waiters;
+        Boolean isLoading;
+        Boolean isStale;
+        uv_fs_event_t* watcher;
+        std::list<Entry*>::iterator lru;
+    };
+
+    typedef std::map<std::string, Entry*> Entries;
+
+    Entries entries;
+
+    // the cached entries, the most recently used first
+    std::list<Entry*> lru;
+
+    Size maxBytes = 0;
+    Size numBytes = 0;
+
+    JsArray::Ptr result(const Waiter& w, int err, Buffer::CPtr content) {
+        JsArray::Ptr args = JsArray::create();
+        args->add(err);
+        if (err)
+            return args;
+
+        if (w.hasEncoding) {
+            args->add(String::create(
+                content->data(),
+                w.enc,
+                content->length()));
+        } else {
+            Buffer::Ptr view(new BufferView(
+                content->data(),
+                content->length(),
+                true,
+                content));
+            args->add(view);
+        }
+        return args;
+    }
+
+    void onWatcherClose(uv_handle_t* handle) {
+        delete reinterpret_cast<uv_fs_event_t*>(handle);
+    }
+
+    void remove(Entry* e) {
+        entries.erase(e->path);
+        if (e->content) {
+            numBytes -= e->content->length();
+            lru.erase(e->lru);
+        }
+        if (e->watcher) {
+            // the watcher does not keep the loop alive
+            uv_ref(uv_default_loop());
+            e->watcher->data = 0;
+            uv_close(
+                reinterpret_cast<uv_handle_t*>(e->watcher),
+                onWatcherClose);
+        }
+        delete e;
+    }
+
+    void evict() {
+        while (numBytes > maxBytes && !lru.empty())
+            remove(lru.back());
+    }
+
+    void onChange(
+        uv_fs_event_t* handle,
+        const char* filename,
+        int events,
+        int status) {
+        Entry* e = static_cast<Entry*>(handle->data);
+        if (!e)
+            return;
+        if (e->isLoading) {
+            e->isStale = true;
+        } else {
+            remove(e);
+        }
+    }
+
+    void watch(Entry* e) {
+        uv_loop_t* loop = uv_default_loop();
+        e->watcher = new uv_fs_event_t;
+        int err = uv_fs_event_init(
+            loop,
+            e->watcher,
+            e->path.c_str(),
+            onChange,
+            0);
+        if (err) {
+            delete e->watcher;
+            e->watcher = 0;
+            e->isStale = true;
+        } else {
+            e->watcher->data = e;
+            uv_unref(loop);
+        }
+    }
+
+    class LoadDone : LIBJ_JS_FUNCTION(LoadDone)
+     public:
+        explicit LoadDone(Entry* entry) : entry_(entry) {}
+
+        Value operator()(JsArray::Ptr args) {
+            Entry* e = entry_;
+            Int err = 0;
+            to<Int>(args->get(0), &err);
+            Buffer::CPtr content = toCPtr<Buffer>(args->get(1));
+
+            std::vector<Waiter> waiters;
+            waiters.swap(e->waiters);
+            e->isLoading = false;
+            if (err ||
+                e->isStale ||
+                !maxBytes ||
+                content->length() > maxBytes) {
+                remove(e);
+            } else {
+                e->content = content;
+                numBytes += content->length();
+                lru.push_front(e);
+                e->lru = lru.begin();
+                evict();
+            }
+
+            for (Size i = 0; i < waiters.size(); i++)
+                (*waiters[i].callback)(result(waiters[i], err, content));
+            return 0;
+        }
+
+     private:
+        Entry* entry_;
+    };
+}
+
+Boolean readFileCached(
+    const std::string& path,
+    Boolean hasEncoding,
+    String::Encoding enc,
+    JsFunction::Ptr callback) {
+    if (!maxBytes)
+        return false;
+
+    Waiter w;
+    w.hasEncoding = hasEncoding;
+    w.enc = enc;
+    w.callback = callback;
+
+    Entries::iterator itr = entries.find(path);
+    if (itr != entries.end()) {
+        Entry* e = itr->second;
+        if (e->isLoading) {
+            if (callback)
+                e->waiters.push_back(w);
+        } else {
+            lru.splice(lru.begin(), lru, e->lru);
+            process::nextTick(callback, result(w, 0, e->content));
+        }
+        return true;
+    }
+
+    Entry* e = new Entry;
+    e->path = path;
+    e->content = LIBJ_NULL(Buffer);
+    e->isLoading = true;
+    e->isStale = false;
+    e->watcher = 0;
+    // without a callback, the file is only loaded into the cache
+    if (callback)
+        e->waiters.push_back(w);
+    entries[path] = e;
+    watch(e);
+    readFileUncached(path, JsFunction::Ptr(new LoadDone(e)));
+    return true;
+}
+
+void setReadCacheSize(Size max) {
+    maxBytes = max;
+    evict();
+}
+
+}  // namespace fs
+}  // namespace node
+}  // namespace libj
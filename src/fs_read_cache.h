@@ -0,0 +1,29 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef SRC_FS_READ_CACHE_H_
+#define SRC_FS_READ_CACHE_H_
+
+#include <libj/js_function.h>
+#include <string>
+
+namespace libj {
+namespace node {
+namespace fs {
+
+// reads 'path' through the read cache, or returns false if the cache
+// is disabled, in which case the callback is not called
+Boolean readFileCached(
+    const std::string& path,
+    Boolean hasEncoding,
+    String::Encoding enc,
+    JsFunction::Ptr callback);
+
+// reads 'path' from the disk. the callback is called with an error code
+// and a Buffer. defined in file_system.cpp.
+void readFileUncached(const std::string& path, JsFunction::Ptr callback);
+
+}  // namespace fs
+}  // namespace node
+}  // namespace libj
+
+#endif  // SRC_FS_READ_CACHE_H_
@@ -0,0 +1,387 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <fcntl.h>
+#include <string.h>
+#include <uv.h>
+#include <string>
+
+#include "libnode/file_system.h"
+#include "./fs_options.h"
+#include "./tick_queue.h"
+
+namespace libj {
+namespace node {
+namespace fs {
+
+const String::CPtr HIGH_WATER_MARK = String::create("highWaterMark");
+const String::CPtr START = String::create("start");
+const String::CPtr END = String::create("end");
+
+const ReadStream::EventId ReadStream::EVENT_OPEN =
+    intern(String::create("open"));
+const ReadStream::EventId ReadStream::EVENT_DATA =
+    intern(String::create("data"));
+const ReadStream::EventId ReadStream::EVENT_END =
+    intern(String::create("end"));
+const ReadStream::EventId ReadStream::EVENT_ERROR =
+    intern(String::create("error"));
+const ReadStream::EventId ReadStream::EVENT_CLOSE =
+    intern(String::create("close"));
+
+static const Size kDefaultHighWaterMark = 64 * 1024;
+
+class ReadStreamImpl : public ReadStream {
+ public:
+    static Ptr create(String::CPtr path, Size start, Size end, Size hwm) {
+        ReadStreamImpl* impl = new ReadStreamImpl(path, start, end, hwm);
+        Ptr p(impl);
+        impl->self_ = p;
+        impl->open();
+        return p;
+    }
+
+    String::CPtr path() const {
+        return path_;
+    }
+
+    Size bytesRead() const {
+        return bytesRead_;
+    }
+
+    Boolean isPaused() const {
+        return isPaused_;
+    }
+
+    void pause() {
+        isPaused_ = true;
+    }
+
+    void resume() {
+        isPaused_ = false;
+        read();
+    }
+
+    // while the file is being opened or read, the stream is only marked,
+    // and closed when the request completes
+    void destroy() {
+        isDestroyed_ = true;
+        if (!isOpening_ && !isReading_)
+            close();
+    }
+
+    void pipe(stream::Writable::Ptr dest);
+
+ private:
+    uv_fs_t req_;
+    uv_file file_;
+    String::CPtr path_;
+    std::string pathStr_;
+    Size pos_;
+    Size end_;
+    Size highWaterMark_;
+    Size bytesRead_;
+    Buffer::Ptr buffer_;
+    Boolean isOpen_;
+    Boolean isOpening_;
+    Boolean isReading_;
+    Boolean isPaused_;
+    Boolean isDestroyed_;
+    Boolean isClosing_;
+
+    // keeps the stream alive until it is closed
+    Ptr self_;
+
+    EventEmitter::Ptr ee_;
+
+    ReadStreamImpl(String::CPtr path, Size start, Size end, Size hwm)
+        : file_(-1)
+        , path_(path)
+        , pathStr_(path->toStdString())
+        , pos_(start)
+        , end_(end)
+        , highWaterMark_(hwm)
+        , bytesRead_(0)
+        , buffer_(LIBJ_NULL(Buffer))
+        , isOpen_(false)
+        , isOpening_(false)
+        , isReading_(false)
+        , isPaused_(false)
+        , isDestroyed_(false)
+        , isClosing_(false)
+        , self_(LIBJ_NULL(ReadStream))
+        , ee_(EventEmitter::create()) {
+        req_.data = this;
+    }
+
+    void open() {
+        isOpening_ = true;
+        int err = uv_fs_open(
+            uv_default_loop(),
+            &req_,
+            pathStr_.c_str(),
+            O_RDONLY,
+            0,
+            afterOpen);
+        if (err) {
+            isOpening_ = false;
+            fail(err);
+        }
+    }
+
+    static void afterOpen(uv_fs_t* req) {
+        ReadStreamImpl* self = static_cast<ReadStreamImpl*>(req->data);
+        int err = req->errorno;
+        uv_file file = req->result;
+        uv_fs_req_cleanup(req);
+        self->isOpening_ = false;
+        if (!err) {
+            self->file_ = file;
+            self->isOpen_ = true;
+        }
+
+        // destroyed while opening, the file just opened is closed
+        // before 'close' is emitted
+        if (self->isDestroyed_) {
+            self->close();
+        } else if (err) {
+            self->fail(err);
+        } else {
+            self->emit(EVENT_OPEN);
+            self->read();
+        }
+        process::runTickQueue();
+    }
+
+    Boolean isAtEnd() const {
+        return end_ != NO_POS && pos_ > end_;
+    }
+
+    void read() {
+        if (!isOpen_ || isReading_ || isPaused_ || isClosing_)
+            return;
+        if (isAtEnd()) {
+            finish();
+            return;
+        }
+
+        Size len = highWaterMark_;
+        if (end_ != NO_POS && end_ - pos_ + 1 < len)
+            len = end_ - pos_ + 1;
+        buffer_ = Buffer::create(len);
+        isReading_ = true;
+        int err = uv_fs_read(
+            uv_default_loop(),
+            &req_,
+            file_,
+            const_cast<void*>(buffer_->data()),
+            len,
+            pos_,
+            afterRead);
+        if (err) {
+            isReading_ = false;
+            fail(err);
+        }
+    }
+
+    static void afterRead(uv_fs_t* req) {
+        ReadStreamImpl* self = static_cast<ReadStreamImpl*>(req->data);
+        int err = req->errorno;
+        ssize_t nread = req->result;
+        uv_fs_req_cleanup(req);
+        self->isReading_ = false;
+
+        Buffer::Ptr buffer = self->buffer_;
+        self->buffer_ = LIBJ_NULL(Buffer);
+        if (self->isDestroyed_) {
+            self->close();
+        } else if (err) {
+            self->fail(err);
+        } else if (!nread) {
+            self->finish();
+        } else {
+            Size n = static_cast<Size>(nread);
+            if (n < buffer->length()) {
+                Buffer::Ptr chunk = Buffer::create(n);
+                memcpy(
+                    const_cast<void*>(chunk->data()),
+                    buffer->data(),
+                    n);
+                buffer = chunk;
+            }
+            self->pos_ += n;
+            self->bytesRead_ += n;
+            self->emit(EVENT_DATA, buffer);
+            if (self->isAtEnd()) {
+                self->finish();
+            } else {
+                self->read();
+            }
+        }
+        process::runTickQueue();
+    }
+
+    void finish() {
+        if (isClosing_)
+            return;
+        emit(EVENT_END);
+        close();
+    }
+
+    void fail(int err) {
+        if (isClosing_)
+            return;
+        emit(EVENT_ERROR, err);
+        close();
+    }
+
+    void close() {
+        if (isClosing_)
+            return;
+        isClosing_ = true;
+        if (isOpen_) {
+            int err = uv_fs_close(
+                uv_default_loop(),
+                &req_,
+                file_,
+                afterClose);
+            if (!err)
+                return;
+        }
+        onClosed();
+    }
+
+    static void afterClose(uv_fs_t* req) {
+        ReadStreamImpl* self = static_cast<ReadStreamImpl*>(req->data);
+        uv_fs_req_cleanup(req);
+        self->onClosed();
+        process::runTickQueue();
+    }
+
+    void onClosed() {
+        isOpen_ = false;
+        Ptr self = self_;
+        self_ = LIBJ_NULL(ReadStream);
+        emit(EVENT_CLOSE);
+        removeAllListeners();
+    }
+
+ public:
+    LIBNODE_EVENT_EMITTER_IMPL(ee_);
+};
+
+class PipeData : LIBJ_JS_FUNCTION(PipeData)
+ public:
+    PipeData(ReadStream* src, stream::Writable::Ptr dest)
+        : src_(src)
+        , dest_(dest) {}
+
+    Value operator()(JsArray::Ptr args) {
+        Buffer::CPtr chunk = toCPtr<Buffer>(args->get(0));
+        if (!dest_->write(chunk))
+            src_->pause();
+        return 0;
+    }
+
+ private:
+    // the listener belongs to the source, so it never outlives it
+    ReadStream* src_;
+    stream::Writable::Ptr dest_;
+};
+
+class PipeDrain : LIBJ_JS_FUNCTION(PipeDrain)
+ public:
+    explicit PipeDrain(ReadStream::Ptr src) : src_(src) {}
+
+    Value operator()(JsArray::Ptr args) {
+        src_->resume();
+        return 0;
+    }
+
+ private:
+    ReadStream::Ptr src_;
+};
+
+// the destination closed before the source, e.g. a response whose
+// client has gone away, so nothing more is read
+class PipeDestClose : LIBJ_JS_FUNCTION(PipeDestClose)
+ public:
+    explicit PipeDestClose(ReadStream::Ptr src) : src_(src) {}
+
+    Value operator()(JsArray::Ptr args) {
+        src_->destroy();
+        return 0;
+    }
+
+ private:
+    ReadStream::Ptr src_;
+};
+
+class PipeClose : LIBJ_JS_FUNCTION(PipeClose)
+ public:
+    PipeClose(
+        stream::Writable::Ptr dest,
+        JsFunction::Ptr drain,
+        JsFunction::Ptr destClose,
+        Boolean isEnd)
+        : dest_(dest)
+        , drain_(drain)
+        , destClose_(destClose)
+        , isEnd_(isEnd) {}
+
+    Value operator()(JsArray::Ptr args) {
+        if (isEnd_) {
+            dest_->end();
+        } else {
+            dest_->removeListener(stream::Writable::EVENT_DRAIN, drain_);
+            dest_->removeListener(stream::Writable::EVENT_CLOSE, destClose_);
+        }
+        return 0;
+    }
+
+ private:
+    stream::Writable::Ptr dest_;
+    JsFunction::Ptr drain_;
+    JsFunction::Ptr destClose_;
+    Boolean isEnd_;
+};
+
+void ReadStreamImpl::pipe(stream::Writable::Ptr dest) {
+    if (!dest || isClosing_)
+        return;
+
+    JsFunction::Ptr data(new PipeData(this, dest));
+    JsFunction::Ptr drain(new PipeDrain(self_));
+    JsFunction::Ptr destClose(new PipeDestClose(self_));
+    JsFunction::Ptr end(new PipeClose(dest, drain, destClose, true));
+    JsFunction::Ptr close(new PipeClose(dest, drain, destClose, false));
+    on(EVENT_DATA, data);
+    on(EVENT_END, end);
+    on(EVENT_CLOSE, close);
+    dest->on(stream::Writable::EVENT_DRAIN, drain);
+    dest->on(stream::Writable::EVENT_CLOSE, destClose);
+}
+
+ReadStream::Ptr createReadStream(String::CPtr path) {
+    LIBJ_NULL_CPTR(JsObject, nullp);
+    return createReadStream(path, nullp);
+}
+
+ReadStream::Ptr createReadStream(String::CPtr path, JsObject::CPtr options) {
+    if (!path) {
+        LIBJ_NULL_PTR(ReadStream, nullp);
+        return nullp;
+    }
+
+    Size hwm = getSizeOption(options, HIGH_WATER_MARK, kDefaultHighWaterMark);
+    if (!hwm)
+        hwm = kDefaultHighWaterMark;
+    return ReadStreamImpl::create(
+        path,
+        getSizeOption(options, START, 0),
+        getSizeOption(options, END, NO_POS),
+        hwm);
+}
+
+}  // namespace fs
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,419 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <uv.h>
+#include <string>
+#include <vector>
+
+#include "./fs_options.h"
+#include "./fs_uring.h"
+#include "./tick_queue.h"
+
+namespace libj {
+namespace node {
+namespace fs {
+namespace uring {
+
+namespace {
+    // a single ring is set up on first use. a sparse table of fixed
+    // files lets an open, a read and a close be linked together, the
+    // open putting the file into a slot of the table which the others
+    // refer to. completions are signaled through an eventfd polled on
+    // the loop. if the kernel lacks any of these, io_uring is not used.
+
+    const unsigned kNumEntries = 256;
+    const int kNumSlots = 64;
+
+    // the largest file read in a single request
+    const Size kMaxReadLen = 1 << 30;
+
+    enum Step {
+        STATX = 0,
+        OPEN = 1,
+        READ = 2,
+        CLOSE = 3
+    };
+
+    struct ReadOp {
+        std::string path;
+        struct statx stx;
+        int slot;
+        Buffer::Ptr buffer;
+        Size nread;
+        int err;
+        int remaining;
+        ReadFileCallback cb;
+        void* data;
+    };
+
+    bool isInitialized = false;
+    bool isAvailable = false;
+
+    int ringFd = -1;
+    int eventFd = -1;
+    uv_poll_t pollHandle;
+    Size numInflight = 0;
+
+    // the SQ and CQ rings share a single mapping
+    void* ringMap = MAP_FAILED;
+    Size ringMapLen = 0;
+    void* sqeMap = MAP_FAILED;
+    Size sqeMapLen = 0;
+
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned sqMask;
+    unsigned sqEntries;
+    unsigned* sqArray;
+    struct io_uring_sqe* sqes;
+    unsigned sqLocalTail = 0;
+    unsigned sqSubmitted = 0;
+
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe* cqes;
+
+    std::vector<int> freeSlots;
+
+    int setup(unsigned entries, struct io_uring_params* params) {
+        return syscall(__NR_io_uring_setup, entries, params);
+    }
+
+    int enter(unsigned toSubmit) {
+        return syscall(__NR_io_uring_enter, ringFd, toSubmit, 0, 0, 0, 0);
+    }
+
+    int registerRing(unsigned opcode, const void* arg, unsigned nargs) {
+        return syscall(__NR_io_uring_register, ringFd, opcode, arg, nargs);
+    }
+
+    bool supportsOps() {
+        Size len = sizeof(struct io_uring_probe)
+            + 256 * sizeof(struct io_uring_probe_op);
+        std::vector<char> buf(len);
+        struct io_uring_probe* probe =
+            reinterpret_cast<struct io_uring_probe*>(&buf[0]);
+        if (registerRing(IORING_REGISTER_PROBE, probe, 256) < 0)
+            return false;
+
+        static const int ops[] = {
+            IORING_OP_STATX,
+            IORING_OP_OPENAT,
+            IORING_OP_READ,
+            IORING_OP_CLOSE
+        };
+        for (Size i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+            if (ops[i] > probe->last_op ||
+                !(probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED))
+                return false;
+        }
+        return true;
+    }
+
+    void onPoll(uv_poll_t* handle, int status, int events);
+
+    bool init() {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ringFd = setup(kNumEntries, &params);
+        if (ringFd < 0)
+            return false;
+
+        unsigned required = IORING_FEAT_SINGLE_MMAP
+            | IORING_FEAT_NODROP
+            | IORING_FEAT_LINKED_FILE;
+        if ((params.features & required) != required || !supportsOps())
+            return false;
+
+        Size sqLen = params.sq_off.array
+            + params.sq_entries * sizeof(unsigned);
+        Size cqLen = params.cq_off.cqes
+            + params.cq_entries * sizeof(struct io_uring_cqe);
+        ringMapLen = sqLen > cqLen ? sqLen : cqLen;
+        ringMap = mmap(
+            0,
+            ringMapLen,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            ringFd,
+            IORING_OFF_SQ_RING);
+        if (ringMap == MAP_FAILED)
+            return false;
+        sqeMapLen = params.sq_entries * sizeof(struct io_uring_sqe);
+        sqeMap = mmap(
+            0,
+            sqeMapLen,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            ringFd,
+            IORING_OFF_SQES);
+        if (sqeMap == MAP_FAILED)
+            return false;
+
+        char* r = static_cast<char*>(ringMap);
+        sqHead = reinterpret_cast<unsigned*>(r + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(r + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(r + params.sq_off.ring_mask);
+        sqEntries = params.sq_entries;
+        sqArray = reinterpret_cast<unsigned*>(r + params.sq_off.array);
+        sqes = static_cast<struct io_uring_sqe*>(sqeMap);
+        sqLocalTail = sqSubmitted = *sqTail;
+        cqHead = reinterpret_cast<unsigned*>(r + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(r + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(r + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<struct io_uring_cqe*>(
+            r + params.cq_off.cqes);
+
+        std::vector<int> files(kNumSlots, -1);
+        if (registerRing(IORING_REGISTER_FILES, &files[0], kNumSlots) < 0)
+            return false;
+        for (int i = kNumSlots - 1; i >= 0; i--)
+            freeSlots.push_back(i);
+
+        eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (eventFd < 0 ||
+            registerRing(IORING_REGISTER_EVENTFD, &eventFd, 1) < 0)
+            return false;
+        return !uv_poll_init(uv_default_loop(), &pollHandle, eventFd);
+    }
+
+    // the ring stays alive while it is mapped, even once its fd is
+    // closed, so whatever init() set up is undone here
+    void release() {
+        if (sqeMap != MAP_FAILED)
+            munmap(sqeMap, sqeMapLen);
+        if (ringMap != MAP_FAILED)
+            munmap(ringMap, ringMapLen);
+        if (eventFd >= 0)
+            close(eventFd);
+        if (ringFd >= 0)
+            close(ringFd);
+        sqeMap = ringMap = MAP_FAILED;
+        eventFd = ringFd = -1;
+        freeSlots.clear();
+    }
+
+    bool hasRoom(unsigned n) {
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        return sqLocalTail - head + n <= sqEntries;
+    }
+
+    struct io_uring_sqe* getSqe(
+        __u8 opcode, ReadOp* op, Step step, __u8 flags) {
+        unsigned idx = sqLocalTail & sqMask;
+        struct io_uring_sqe* sqe = &sqes[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->flags = flags;
+        sqe->user_data = reinterpret_cast<__u64>(op) | step;
+        sqArray[idx] = idx;
+        sqLocalTail++;
+        return sqe;
+    }
+
+    // returns false if the kernel took only some of the entries, e.g.
+    // with EAGAIN or EBUSY. the rest stay on the ring, to be submitted
+    // after the next completions, unless they are taken back.
+    bool submit() {
+        __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+        while (sqSubmitted != sqLocalTail) {
+            int n = enter(sqLocalTail - sqSubmitted);
+            if (n > 0) {
+                sqSubmitted += n;
+            } else if (!n || errno != EINTR) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // takes back the last n entries, if none of them has been submitted
+    bool takeBack(unsigned n) {
+        if (sqLocalTail - sqSubmitted < n)
+            return false;
+        sqLocalTail -= n;
+        __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    void addInflight() {
+        if (!numInflight++)
+            uv_poll_start(&pollHandle, UV_READABLE, onPoll);
+    }
+
+    void removeInflight() {
+        if (!--numInflight)
+            uv_poll_stop(&pollHandle);
+    }
+
+    void finish(ReadOp* op, int err, Buffer::Ptr buffer) {
+        removeInflight();
+        op->cb(op->data, err, buffer);
+        delete op;
+    }
+
+    void startRead(ReadOp* op) {
+        Size size = static_cast<Size>(op->stx.stx_size);
+        if (!S_ISREG(op->stx.stx_mode) ||
+            !size ||
+            size > kMaxReadLen ||
+            freeSlots.empty() ||
+            !hasRoom(3)) {
+            finish(op, 0, LIBJ_NULL(Buffer));
+            return;
+        }
+
+        op->slot = freeSlots.back();
+        freeSlots.pop_back();
+        op->buffer = Buffer::create(size);
+        op->remaining = 3;
+
+        // the read is hard-linked to the close, so that the file is
+        // closed even if the read fails
+        struct io_uring_sqe* sqe =
+            getSqe(IORING_OP_OPENAT, op, OPEN, IOSQE_IO_LINK);
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<__u64>(op->path.c_str());
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->file_index = op->slot + 1;
+
+        sqe = getSqe(
+            IORING_OP_READ, op, READ, IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK);
+        sqe->fd = op->slot;
+        sqe->addr = reinterpret_cast<__u64>(op->buffer->data());
+        sqe->len = size;
+        sqe->off = 0;
+
+        sqe = getSqe(IORING_OP_CLOSE, op, CLOSE, 0);
+        sqe->file_index = op->slot + 1;
+
+        // as nothing of the file has been read yet, it is read on the
+        // thread pool instead. if only part of the link was taken, the
+        // rest is submitted with the completions of that part.
+        if (!submit() && takeBack(3)) {
+            freeSlots.push_back(op->slot);
+            finish(op, 0, LIBJ_NULL(Buffer));
+        }
+    }
+
+    void complete(ReadOp* op, Step step, int res) {
+        switch (step) {
+        case STATX:
+            if (res < 0) {
+                finish(op, toErrorCode(-res), LIBJ_NULL(Buffer));
+            } else {
+                startRead(op);
+            }
+            return;
+        case OPEN:
+            if (res < 0)
+                op->err = -res;
+            break;
+        case READ:
+            if (res < 0) {
+                if (!op->err && res != -ECANCELED)
+                    op->err = -res;
+            } else {
+                op->nread = res;
+            }
+            break;
+        case CLOSE:
+            break;
+        }
+        if (--op->remaining)
+            return;
+
+        freeSlots.push_back(op->slot);
+        if (op->err) {
+            finish(op, toErrorCode(op->err), LIBJ_NULL(Buffer));
+            return;
+        }
+
+        // the file may have been shrunk since its size was taken
+        Buffer::Ptr buffer = op->buffer;
+        if (op->nread < buffer->length()) {
+            Buffer::Ptr b = Buffer::create(op->nread);
+            memcpy(const_cast<void*>(b->data()), buffer->data(), op->nread);
+            buffer = b;
+        }
+        finish(op, 0, buffer);
+    }
+
+    void onPoll(uv_poll_t* handle, int status, int events) {
+        uint64_t count;
+        if (read(eventFd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+            return;
+
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            struct io_uring_cqe* cqe = &cqes[head & cqMask];
+            __u64 userData = cqe->user_data;
+            int res = cqe->res;
+            head++;
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+            ReadOp* op = reinterpret_cast<ReadOp*>(userData & ~__u64(3));
+            complete(op, static_cast<Step>(userData & 3), res);
+            tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        }
+
+        // entries left by a failed submit, now that the completions
+        // have made room for them
+        if (sqSubmitted != sqLocalTail)
+            submit();
+        process::runTickQueue();
+    }
+}
+
+Boolean available() {
+    if (!isInitialized) {
+        isInitialized = true;
+        isAvailable = init();
+        if (!isAvailable)
+            release();
+    }
+    return isAvailable;
+}
+
+Boolean readFile(const char* path, ReadFileCallback cb, void* data) {
+    if (!available() || !hasRoom(1))
+        return false;
+
+    ReadOp* op = new ReadOp;
+    op->path = path;
+    op->slot = -1;
+    op->buffer = LIBJ_NULL(Buffer);
+    op->nread = 0;
+    op->err = 0;
+    op->remaining = 0;
+    op->cb = cb;
+    op->data = data;
+    addInflight();
+
+    struct io_uring_sqe* sqe = getSqe(IORING_OP_STATX, op, STATX, 0);
+    sqe->fd = AT_FDCWD;
+    sqe->addr = reinterpret_cast<__u64>(op->path.c_str());
+    sqe->len = STATX_TYPE | STATX_SIZE;
+    sqe->off = reinterpret_cast<__u64>(&op->stx);
+    if (!submit() && takeBack(1)) {
+        removeInflight();
+        delete op;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace uring
+}  // namespace fs
+}  // namespace node
+}  // namespace libj
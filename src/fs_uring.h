@@ -0,0 +1,35 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef SRC_FS_URING_H_
+#define SRC_FS_URING_H_
+
+#include "libnode/buffer.h"
+
+namespace libj {
+namespace node {
+namespace fs {
+namespace uring {
+
+// called on the loop thread with a libuv error code, which is 0 on
+// success. if neither an error nor a Buffer is given, the file is not
+// one io_uring reads in a single request (e.g. it is not a regular file,
+// or its size is unknown) or the request could not be submitted, and it
+// should be read on the thread pool.
+typedef void (*ReadFileCallback)(void* data, int err, Buffer::Ptr buffer);
+
+// whether the kernel supports what readFile() needs. the ring is set up
+// by the first call.
+Boolean available();
+
+// starts reading a whole file with a statx, and then an open, a read and
+// a close linked together, all completed on the loop. returns false if
+// io_uring is not available or the request cannot be submitted, in which
+// case the callback is not called.
+Boolean readFile(const char* path, ReadFileCallback cb, void* data);
+
+}  // namespace uring
+}  // namespace fs
+}  // namespace node
+}  // namespace libj
+
+#endif  // SRC_FS_URING_H_
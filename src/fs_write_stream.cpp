@@ -0,0 +1,539 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <uv.h>
+#include <string>
+#include <vector>
+
+#include "libnode/file_system.h"
+#include "libnode/process.h"
+#include "./fs_options.h"
+#include "./tick_queue.h"
+
+namespace libj {
+namespace node {
+namespace fs {
+
+const String::CPtr FLAGS = String::create("flags");
+const String::CPtr SYNC = String::create("sync");
+const String::CPtr SYNC_NONE = String::create("none");
+const String::CPtr SYNC_WRITE = String::create("write");
+const String::CPtr SYNC_END = String::create("end");
+
+const WriteStream::EventId WriteStream::EVENT_OPEN =
+    intern(String::create("open"));
+const WriteStream::EventId WriteStream::EVENT_ERROR =
+    intern(String::create("error"));
+const WriteStream::EventId WriteStream::EVENT_FINISH =
+    intern(String::create("finish"));
+const WriteStream::EventId WriteStream::EVENT_CLOSE =
+    intern(String::create("close"));
+
+static const Size kDefaultHighWaterMark = 64 * 1024;
+
+#ifdef IOV_MAX
+static const Size kMaxIovecs = IOV_MAX;
+#else
+static const Size kMaxIovecs = 1024;
+#endif
+
+// runs on the thread pool. returns 0 or errno.
+static int writeAll(int fd, struct iovec* iov, Size n) {
+    while (n) {
+        int cnt = static_cast<int>(n < kMaxIovecs ? n : kMaxIovecs);
+        ssize_t r = writev(fd, iov, cnt);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno;
+        }
+
+        // skips what has been written, which may end in the middle of
+        // a chunk
+        Size done = static_cast<Size>(r);
+        while (n && done >= iov->iov_len) {
+            done -= iov->iov_len;
+            iov++;
+            n--;
+        }
+        if (n) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + done;
+            iov->iov_len -= done;
+        }
+    }
+    return 0;
+}
+
+class WriteStreamImpl : public WriteStream {
+ public:
+    enum SyncMode {
+        NONE,
+        WRITE,
+        END
+    };
+
+    static Ptr create(
+        String::CPtr path, int flags, SyncMode sync, Size hwm) {
+        WriteStreamImpl* impl = new WriteStreamImpl(path, flags, sync, hwm);
+        Ptr p(impl);
+        impl->self_ = p;
+        impl->open();
+        return p;
+    }
+
+    String::CPtr path() const {
+        return path_;
+    }
+
+    Size bytesWritten() const {
+        return bytesWritten_;
+    }
+
+    Boolean write(Object::CPtr chunk) {
+        if (isEnded_ || isClosing_ || !chunk)
+            return false;
+
+        Buffer::CPtr buffer = toCPtr<Buffer>(chunk);
+        Size length;
+        if (buffer) {
+            length = buffer->length();
+            if (length) {
+                pending_.push_back(Chunk());
+                pending_.back().buffer = buffer;
+            }
+        } else {
+            String::CPtr s = toCPtr<String>(chunk);
+            std::string str = (s ? s : chunk->toString())->toStdString();
+            length = str.length();
+            if (length) {
+                pending_.push_back(Chunk());
+                pending_.back().str.swap(str);
+            }
+        }
+        numQueued_ += length;
+        scheduleWrite();
+
+        if (numQueued_ >= highWaterMark_) {
+            needDrain_ = true;
+            return false;
+        } else {
+            return true;
+        }
+    }
+
+    void end() {
+        if (isEnded_)
+            return;
+        isEnded_ = true;
+        scheduleWrite();
+    }
+
+    void flush(JsFunction::Ptr callback) {
+        if (isClosing_) {
+            if (callback) {
+                JsArray::Ptr args = JsArray::create();
+                args->add(static_cast<Int>(UV_EBADF));
+                process::nextTick(callback, args);
+            }
+            return;
+        }
+        needSync_ = true;
+        if (callback)
+            flushCallbacks_.push_back(callback);
+        scheduleWrite();
+    }
+
+    // starts a write of everything pending, unless one is in progress
+    void writeNext() {
+        isScheduled_ = false;
+        if (!isOpen_ || isWriting_ || isClosing_)
+            return;
+
+        Boolean syncAtEnd = isEnded_ && syncMode_ == END && isDirty_;
+        if (pending_.empty() && !needSync_ && !syncAtEnd) {
+            if (isEnded_)
+                finish();
+            return;
+        }
+
+        writing_.swap(pending_);
+        callbacks_.swap(flushCallbacks_);
+        iovecs_.resize(writing_.size());
+        writingLength_ = 0;
+        for (Size i = 0; i < writing_.size(); i++) {
+            const Chunk& c = writing_[i];
+            if (c.buffer) {
+                iovecs_[i].iov_base = const_cast<void*>(c.buffer->data());
+                iovecs_[i].iov_len = c.buffer->length();
+            } else {
+                iovecs_[i].iov_base = const_cast<char*>(c.str.data());
+                iovecs_[i].iov_len = c.str.length();
+            }
+            writingLength_ += iovecs_[i].iov_len;
+        }
+        doSync_ = syncMode_ == WRITE
+            || needSync_
+            || (isEnded_ && syncMode_ == END);
+        needSync_ = false;
+        workErr_ = 0;
+
+        isWriting_ = true;
+        work_.data = this;
+        int err = uv_queue_work(
+            uv_default_loop(),
+            &work_,
+            doWrite,
+            afterWrite);
+        if (err) {
+            isWriting_ = false;
+            fail(err);
+        }
+    }
+
+ private:
+    struct Chunk {
+        Buffer::CPtr buffer;
+        std::string str;
+    };
+
+    uv_fs_t req_;
+    uv_work_t work_;
+    uv_file file_;
+    String::CPtr path_;
+    std::string pathStr_;
+    int flags_;
+    SyncMode syncMode_;
+    Size highWaterMark_;
+    Size bytesWritten_;
+    Size numQueued_;
+
+    // chunks written since the current write started, and the ones
+    // being written, with their iovecs
+    std::vector<Chunk> pending_;
+    std::vector<Chunk> writing_;
+    std::vector<struct iovec> iovecs_;
+    Size writingLength_;
+
+    // callbacks of flush() waiting for the next write, and for the
+    // current one
+    std::vector<JsFunction::Ptr> flushCallbacks_;
+    std::vector<JsFunction::Ptr> callbacks_;
+
+    int workErr_;
+    Boolean doSync_;
+    Boolean needSync_;
+    Boolean isDirty_;
+    Boolean isOpen_;
+    Boolean isWriting_;
+    Boolean isScheduled_;
+    Boolean isEnded_;
+    Boolean isClosing_;
+    Boolean needDrain_;
+
+    // keeps the stream alive until it is closed
+    Ptr self_;
+
+    EventEmitter::Ptr ee_;
+
+    WriteStreamImpl(String::CPtr path, int flags, SyncMode sync, Size hwm)
+        : file_(-1)
+        , path_(path)
+        , pathStr_(path->toStdString())
+        , flags_(flags)
+        , syncMode_(sync)
+        , highWaterMark_(hwm)
+        , bytesWritten_(0)
+        , numQueued_(0)
+        , writingLength_(0)
+        , workErr_(0)
+        , doSync_(false)
+        , needSync_(false)
+        , isDirty_(false)
+        , isOpen_(false)
+        , isWriting_(false)
+        , isScheduled_(false)
+        , isEnded_(false)
+        , isClosing_(false)
+        , needDrain_(false)
+        , self_(LIBJ_NULL(WriteStream))
+        , ee_(EventEmitter::create()) {
+        req_.data = this;
+    }
+
+    void scheduleWrite();
+
+    void open() {
+        int err = uv_fs_open(
+            uv_default_loop(),
+            &req_,
+            pathStr_.c_str(),
+            flags_,
+            438,
+            afterOpen);
+        if (err)
+            fail(err);
+    }
+
+    static void afterOpen(uv_fs_t* req) {
+        WriteStreamImpl* self = static_cast<WriteStreamImpl*>(req->data);
+        int err = req->errorno;
+        uv_file file = req->result;
+        uv_fs_req_cleanup(req);
+        if (err) {
+            self->fail(err);
+        } else {
+            self->file_ = file;
+            self->isOpen_ = true;
+            self->emit(EVENT_OPEN);
+            self->writeNext();
+        }
+        process::runTickQueue();
+    }
+
+    static void doWrite(uv_work_t* work) {
+        WriteStreamImpl* self = static_cast<WriteStreamImpl*>(work->data);
+        int err = 0;
+        if (!self->iovecs_.empty())
+            err = writeAll(
+                self->file_,
+                &self->iovecs_[0],
+                self->iovecs_.size());
+        if (!err && self->doSync_ && fdatasync(self->file_))
+            err = errno;
+        self->workErr_ = err;
+    }
+
+    static void afterWrite(uv_work_t* work) {
+        WriteStreamImpl* self = static_cast<WriteStreamImpl*>(work->data);
+        self->isWriting_ = false;
+        self->numQueued_ -= self->writingLength_;
+        self->writing_.clear();
+        self->iovecs_.clear();
+
+        int err = self->workErr_ ? toErrorCode(self->workErr_) : 0;
+        if (!err) {
+            self->bytesWritten_ += self->writingLength_;
+            if (self->doSync_) {
+                self->isDirty_ = false;
+            } else if (self->writingLength_) {
+                self->isDirty_ = true;
+            }
+        }
+        self->writingLength_ = 0;
+
+        std::vector<JsFunction::Ptr> callbacks;
+        callbacks.swap(self->callbacks_);
+        for (Size i = 0; i < callbacks.size(); i++) {
+            JsArray::Ptr args = JsArray::create();
+            args->add(err);
+            (*callbacks[i])(args);
+        }
+
+        if (err) {
+            self->fail(err);
+        } else {
+            if (self->needDrain_ && self->numQueued_ < self->highWaterMark_) {
+                self->needDrain_ = false;
+                self->emit(EVENT_DRAIN);
+            }
+            self->writeNext();
+        }
+        process::runTickQueue();
+    }
+
+    void finish() {
+        if (isClosing_)
+            return;
+        emit(EVENT_FINISH);
+        close();
+    }
+
+    void fail(int err) {
+        if (isClosing_)
+            return;
+        emit(EVENT_ERROR, err);
+
+        std::vector<JsFunction::Ptr> callbacks;
+        callbacks.swap(flushCallbacks_);
+        for (Size i = 0; i < callbacks.size(); i++) {
+            JsArray::Ptr args = JsArray::create();
+            args->add(err);
+            (*callbacks[i])(args);
+        }
+        close();
+    }
+
+    void close() {
+        if (isClosing_)
+            return;
+        isClosing_ = true;
+        pending_.clear();
+        numQueued_ = 0;
+        if (isOpen_) {
+            int err = uv_fs_close(
+                uv_default_loop(),
+                &req_,
+                file_,
+                afterClose);
+            if (!err)
+                return;
+        }
+        onClosed();
+    }
+
+    static void afterClose(uv_fs_t* req) {
+        WriteStreamImpl* self = static_cast<WriteStreamImpl*>(req->data);
+        uv_fs_req_cleanup(req);
+        self->onClosed();
+        process::runTickQueue();
+    }
+
+    void onClosed() {
+        isOpen_ = false;
+        Ptr self = self_;
+        self_ = LIBJ_NULL(WriteStream);
+        emit(EVENT_CLOSE);
+        removeAllListeners();
+    }
+
+ public:
+    LIBNODE_EVENT_EMITTER_IMPL(ee_);
+};
+
+class WriteTick : LIBJ_JS_FUNCTION(WriteTick)
+ public:
+    WriteTick(WriteStreamImpl* impl, WriteStream::Ptr stream)
+        : impl_(impl)
+        , stream_(stream) {}
+
+    Value operator()(JsArray::Ptr args) {
+        impl_->writeNext();
+        return 0;
+    }
+
+ private:
+    WriteStreamImpl* impl_;
+
+    // keeps the stream alive until the tick
+    WriteStream::Ptr stream_;
+};
+
+// chunks written until the current callback returns are written together
+// on the next tick. while a write is in progress, they wait for it to
+// complete instead.
+void WriteStreamImpl::scheduleWrite() {
+    if (isScheduled_ || isWriting_ || !isOpen_ || isClosing_)
+        return;
+    isScheduled_ = true;
+    JsFunction::Ptr tick(new WriteTick(this, self_));
+    process::nextTick(tick, JsArray::create());
+}
+
+WriteStream::Ptr createWriteStream(String::CPtr path) {
+    LIBJ_NULL_CPTR(JsObject, nullp);
+    return createWriteStream(path, nullp);
+}
+
+WriteStream::Ptr createWriteStream(
+    String::CPtr path, JsObject::CPtr options) {
+    static const String::CPtr append = String::create("a");
+
+    if (!path) {
+        LIBJ_NULL_PTR(WriteStream, nullp);
+        return nullp;
+    }
+
+    int flags = O_WRONLY | O_CREAT;
+    String::CPtr f = getStringOption(options, FLAGS, String::create("w"));
+    if (f->compareTo(append) == 0) {
+        flags |= O_APPEND;
+    } else {
+        flags |= O_TRUNC;
+    }
+
+    WriteStreamImpl::SyncMode sync = WriteStreamImpl::NONE;
+    String::CPtr s = getStringOption(options, SYNC, SYNC_NONE);
+    if (s->compareTo(SYNC_WRITE) == 0) {
+        sync = WriteStreamImpl::WRITE;
+    } else if (s->compareTo(SYNC_END) == 0) {
+        sync = WriteStreamImpl::END;
+    }
+
+    Size hwm = getSizeOption(options, HIGH_WATER_MARK, kDefaultHighWaterMark);
+    if (!hwm)
+        hwm = kDefaultHighWaterMark;
+    return WriteStreamImpl::create(path, flags, sync, hwm);
+}
+
+class WriteFileDone : LIBJ_JS_FUNCTION(WriteFileDone)
+ public:
+    explicit WriteFileDone(JsFunction::Ptr callback)
+        : callback_(callback)
+        , isDone_(false) {}
+
+    Value operator()(JsArray::Ptr args) {
+        if (isDone_)
+            return 0;
+        isDone_ = true;
+
+        // 'error' is emitted with an error code, and 'close' without
+        Int err = 0;
+        to<Int>(args->get(0), &err);
+        if (callback_) {
+            JsArray::Ptr res = JsArray::create();
+            res->add(err);
+            (*callback_)(res);
+        }
+        return 0;
+    }
+
+ private:
+    JsFunction::Ptr callback_;
+    Boolean isDone_;
+};
+
+static void writeFile(
+    String::CPtr fileName,
+    Object::CPtr data,
+    String::CPtr flags,
+    JsFunction::Ptr callback) {
+    JsObject::Ptr options = JsObject::create();
+    options->put(FLAGS, flags);
+    WriteStream::Ptr stream = createWriteStream(fileName, options);
+    if (!stream) {
+        if (callback) {
+            JsArray::Ptr args = JsArray::create();
+            args->add(static_cast<Int>(UV_EINVAL));
+            (*callback)(args);
+        }
+        return;
+    }
+
+    JsFunction::Ptr done(new WriteFileDone(callback));
+    stream->on(WriteStream::EVENT_ERROR, done);
+    stream->on(WriteStream::EVENT_CLOSE, done);
+    stream->write(data);
+    stream->end();
+}
+
+void writeFile(
+    String::CPtr fileName,
+    Object::CPtr data,
+    JsFunction::Ptr callback) {
+    writeFile(fileName, data, String::create("w"), callback);
+}
+
+void appendFile(
+    String::CPtr fileName,
+    Object::CPtr data,
+    JsFunction::Ptr callback) {
+    writeFile(fileName, data, String::create("a"), callback);
+}
+
+}  // namespace fs
+}  // namespace node
+}  // namespace libj
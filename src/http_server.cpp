@@ -1,10 +1,13 @@
 // Copyright (c) 2012 Plenluno All rights reserved.
 
+#include <string.h>
 #include <uv.h>
 #include <string>
 
+#include "libnode/buffer.h"
 #include "libnode/http_server.h"
 #include "./http_server_context.h"
+#include "./tick_queue.h"
 
 namespace libj {
 namespace node {
@@ -80,9 +83,8 @@ class ServerImpl : public Server {
             ServerImpl::onAlloc,
             ServerImpl::onRead);
 
-        JsArray::Ptr args = JsArray::create();
-        args->add(context->socket);
-        server->emit(EVENT_CONNECTION, args);
+        server->emit(EVENT_CONNECTION, context->socket);
+        process::runTickQueue();
     }
 
     static uv_buf_t onAlloc(uv_handle_t* handle, size_t suggestedSize) {
@@ -114,18 +116,15 @@ class ServerImpl : public Server {
                                 nread);
             if (parsed < static_cast<size_t>(nread)) {
                 // parse error
-                uv_close(
-                    reinterpret_cast<uv_handle_t*>(stream),
-                    ServerImpl::onClose);
+                context->close();
             }
         } else {
             // uv_err_t err = uv_last_error(uv_default_loop());
             // assert(err.code == UV_EOF);
-            uv_close(
-                reinterpret_cast<uv_handle_t*>(stream),
-                ServerImpl::onClose);
+            context->close();
         }
         free(buf.base);
+        process::runTickQueue();
     }
 
     static int onUrl(http_parser* parser, const char* at, size_t length) {
@@ -155,6 +154,8 @@ class ServerImpl : public Server {
         static const String::CPtr methodGet = String::create("GET");
         static const String::CPtr methodPost = String::create("POST");
         static const String::CPtr dot = String::create(".");
+        static const String::CPtr http11 = String::create("1.1");
+        static const String::CPtr http10 = String::create("1.0");
 
         ServerContext* context = static_cast<ServerContext*>(parser->data);
         switch (parser->method) {
@@ -170,18 +171,21 @@ class ServerImpl : public Server {
 
         Int majorVer = static_cast<Int>(parser->http_major);
         Int minorVer = static_cast<Int>(parser->http_minor);
-        String::CPtr httpVer = String::valueOf(majorVer);
-        httpVer = httpVer->concat(dot);
-        httpVer = httpVer->concat(String::valueOf(minorVer));
-        context->request->setHttpVersion(httpVer);
+        if (majorVer == 1 && minorVer == 1) {
+            context->request->setHttpVersion(http11);
+        } else if (majorVer == 1 && minorVer == 0) {
+            context->request->setHttpVersion(http10);
+        } else {
+            String::CPtr httpVer = String::valueOf(majorVer);
+            httpVer = httpVer->concat(dot);
+            httpVer = httpVer->concat(String::valueOf(minorVer));
+            context->request->setHttpVersion(httpVer);
+        }
 
-        JsArray::Ptr args = JsArray::create();
         ServerRequest::Ptr req(context->request);
         ServerResponse::Ptr res(context->response);
-        args->add(req);
-        args->add(res);
         ServerImpl* server = static_cast<ServerImpl*>(context->server);
-        server->emit(Server::EVENT_REQUEST, args);
+        server->emit(Server::EVENT_REQUEST, req, res);
         return 0;
     }
 
@@ -191,21 +195,26 @@ class ServerImpl : public Server {
 
     static int onBody(http_parser* parser, const char* at, size_t length) {
         ServerContext* context = static_cast<ServerContext*>(parser->data);
-        if (context->request) {
+        if (!context->request ||
+            !context->request->hasListeners(ServerRequest::EVENT_DATA))
+            return 0;
+
+        if (context->request->isBinary()) {
+            // the read buffer is freed after parsing, so it is copied
+            Buffer::Ptr chunk = Buffer::create(length);
+            memcpy(const_cast<void*>(chunk->data()), at, length);
+            context->request->emit(ServerRequest::EVENT_DATA, chunk);
+        } else {
             String::CPtr chunk = String::create(at, String::ASCII, length);
-            JsArray::Ptr args = JsArray::create();
-            args->add(chunk);
-            context->request->emit(ServerRequest::EVENT_DATA, args);
+            context->request->emit(ServerRequest::EVENT_DATA, chunk);
         }
         return 0;
     }
 
     static int onMessageComplete(http_parser* parser) {
         ServerContext* context = static_cast<ServerContext*>(parser->data);
-        if (context->request) {
-            JsArray::Ptr args = JsArray::create();
-            context->request->emit(ServerRequest::EVENT_END, args);
-        }
+        if (context->request)
+            context->request->emit(ServerRequest::EVENT_END);
         return 0;
     }
 
@@ -227,9 +236,12 @@ LIBJ_NULL_CPTR(String, ServerImpl::headerName);
 http_parser_settings ServerImpl::settings = {};
 
 const String::CPtr Server::IN_ADDR_ANY = String::create("0.0.0.0");
-const String::CPtr Server::EVENT_REQUEST = String::create("request");
-const String::CPtr Server::EVENT_CONNECTION = String::create("connection");
-const String::CPtr Server::EVENT_CLOSE = String::create("close");
+const Server::EventId Server::EVENT_REQUEST =
+    intern(String::create("request"));
+const Server::EventId Server::EVENT_CONNECTION =
+    intern(String::create("connection"));
+const Server::EventId Server::EVENT_CLOSE =
+    intern(String::create("close"));
 
 Server::Ptr Server::create() {
     return ServerImpl::create();
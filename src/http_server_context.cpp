@@ -0,0 +1,30 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include "./http_server_context.h"
+#include "./tick_queue.h"
+
+namespace libj {
+namespace node {
+namespace http {
+
+void ServerContext::close() {
+    uv_handle_t* handle =
+        reinterpret_cast<uv_handle_t*>(socket->getTcp());
+    if (isClosed || uv_is_closing(handle))
+        return;
+    isClosed = true;
+    handle->data = this;
+    uv_close(handle, ServerContext::onClose);
+}
+
+void ServerContext::onClose(uv_handle_t* handle) {
+    ServerContext* context = static_cast<ServerContext*>(handle->data);
+    if (context->response)
+        context->response->detach();
+    delete context;
+    process::runTickQueue();
+}
+
+}  // namespace http
+}  // namespace node
+}  // namespace libj
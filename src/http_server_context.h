@@ -20,15 +20,25 @@ class ServerContext {
         : server(srv)
         , socket(net::SocketImpl::create())
         , request(LIBJ_NULL(ServerRequestImpl))
-        , response(LIBJ_NULL(ServerResponseImpl)) {
+        , response(LIBJ_NULL(ServerResponseImpl))
+        , isClosed(false) {
     }
 
+    // closes the connection, whether the response has ended or the
+    // client has gone away. the context is deleted once it is closed,
+    // after the response has emitted 'close'.
+    void close();
+
     http_parser parser;
     uv_write_t write;
     void* server;
     net::SocketImpl::Ptr socket;
     ServerRequestImpl::Ptr request;
     ServerResponseImpl::Ptr response;
+    Boolean isClosed;
+
+ private:
+    static void onClose(uv_handle_t* handle);
 };
 
 }  // namespace http
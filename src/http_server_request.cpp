@@ -6,9 +6,12 @@ namespace libj {
 namespace node {
 namespace http {
 
-const String::CPtr ServerRequest::EVENT_DATA = String::create("data");
-const String::CPtr ServerRequest::EVENT_END = String::create("end");
-const String::CPtr ServerRequest::EVENT_CLOSE = String::create("close");
+const ServerRequest::EventId ServerRequest::EVENT_DATA =
+    intern(String::create("data"));
+const ServerRequest::EventId ServerRequest::EVENT_END =
+    intern(String::create("end"));
+const ServerRequest::EventId ServerRequest::EVENT_CLOSE =
+    intern(String::create("close"));
 
 }  // namespace http
 }  // namespace node
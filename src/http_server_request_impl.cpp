@@ -17,12 +17,13 @@ const String::CPtr ServerRequestImpl::HTTP_VERSION =
     String::create("httpVerion");
 
 ServerRequestImpl::ServerRequestImpl(ServerContext* context)
-    : context_(context)
+    : socket_(context->socket)
+    , isBinary_(false)
     , ee_(EventEmitter::create()) {
 }
 
 net::Socket::Ptr ServerRequestImpl::connection() const {
-    return context_->socket;
+    return socket_;
 }
 
 }  // namespace http
@@ -39,6 +39,14 @@ class ServerRequestImpl : public ServerRequest {
 
     net::Socket::Ptr connection() const;
 
+    Boolean isBinary() const {
+        return isBinary_;
+    }
+
+    void setBinary(Boolean binary) {
+        isBinary_ = binary;
+    }
+
     void setMethod(String::CPtr method) {
         put(METHOD, method);
     }
@@ -61,7 +69,10 @@ class ServerRequestImpl : public ServerRequest {
     }
 
  private:
-    ServerContext* context_;
+    // the socket rather than the context, which is deleted when the
+    // connection closes while the request may still be referenced
+    net::Socket::Ptr socket_;
+    Boolean isBinary_;
 
     EventEmitter::Ptr ee_;
 
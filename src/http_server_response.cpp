@@ -6,7 +6,8 @@ namespace libj {
 namespace node {
 namespace http {
 
-const String::CPtr ServerResponse::EVENT_CLOSE = String::create("close");
+const ServerResponse::EventId ServerResponse::EVENT_CLOSE =
+    intern(String::create("close"));
 
 }  // namespace http
 }  // namespace node
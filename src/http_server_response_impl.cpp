@@ -1,7 +1,10 @@
 // Copyright (c) 2012 Plenluno All rights reserved.
 
+#include <stdio.h>
+
 #include "./http_server_context.h"
 #include "./http_server_response_impl.h"
+#include "./tick_queue.h"
 
 namespace libj {
 namespace node {
@@ -11,27 +14,192 @@ const String::CPtr ServerResponseImpl::HEADERS =
     String::create("headers");
 const String::CPtr ServerResponseImpl::STATUS_CODE =
     String::create("statusCode");
+const String::CPtr ServerResponseImpl::CONTENT_LENGTH =
+    String::create("Content-Length");
+const String::CPtr ServerResponseImpl::TRANSFER_ENCODING =
+    String::create("Transfer-Encoding");
+const String::CPtr ServerResponseImpl::CHUNKED =
+    String::create("chunked");
+
+// a write of the streamed body. it keeps the chunk alive, either the
+// Buffer written or its own copy of the bytes, until the write completes.
+struct ServerResponseImpl::WriteReq {
+    uv_write_t write;
+    ServerResponseImpl* res;
+    Buffer::CPtr buffer;
+    std::string data;
+    char sizeLine[24];
+    Size length;
+};
 
 ServerResponseImpl::ServerResponseImpl(ServerContext* context)
     : context_(context)
     , status_(LIBJ_NULL(http::Status))
-    , res_(StringBuffer::create())
-    , body_(StringBuffer::create())
+    , isHeadSent_(false)
+    , isChunked_(false)
+    , isEnded_(false)
+    , needDrain_(false)
+    , numQueued_(0)
+    , numWrites_(0)
     , ee_(EventEmitter::create()) {
     resBuf_.base = 0;
+    resBuf_.len = 0;
 }
 
-ServerResponseImpl::~ServerResponseImpl() {
-    free(resBuf_.base);
+void ServerResponseImpl::makeHead() {
+    res_.clear();
+    res_.append("HTTP/1.1 ");
+    if (status_) {
+        res_.append(String::valueOf(status_->code())->toStdString());
+        res_.append(" ");
+        res_.append(status_->toString()->toStdString());
+        res_.append("\r\n");
+    } else {
+        res_.append("200 OK\r\n");
+    }
+    JsObject::Ptr headers = getHeaders();
+    Set::CPtr ks = headers->keySet();
+    Iterator::Ptr itr = ks->iterator();
+    while (itr->hasNext()) {
+        String::CPtr name = toCPtr<String>(itr->next());
+        String::CPtr value = toCPtr<String>(headers->get(name));
+        res_.append(name->toStdString());
+        res_.append(": ");
+        res_.append(value->toStdString());
+        res_.append("\r\n");
+    }
+    res_.append("\r\n");
 }
 
-void ServerResponseImpl::end() {
-    makeResponse();
-    makeResBuf();
-    uv_write_t* write = &context_->write;
+void ServerResponseImpl::makeResponse() {
+    setHeader(
+        CONTENT_LENGTH,
+        String::valueOf(static_cast<Int>(body_.length())));
+    makeHead();
+    res_.append(body_);
+}
+
+Boolean ServerResponseImpl::write(Object::CPtr chunk) {
+    if (isEnded_ || !chunk || isClosed())
+        return false;
+
+    // Buffers are written as they are, anything else as the UTF-8 of
+    // its string form
+    const char* data;
+    Size length;
+    std::string str;
+    Buffer::CPtr buffer = toCPtr<Buffer>(chunk);
+    if (buffer) {
+        data = static_cast<const char*>(buffer->data());
+        length = buffer->length();
+    } else {
+        String::CPtr s = toCPtr<String>(chunk);
+        str = (s ? s : chunk->toString())->toStdString();
+        data = str.data();
+        length = str.length();
+    }
+
+    if (!isHeadSent_) {
+        if (body_.length() + length <= BUFFERED_LENGTH) {
+            body_.append(data, length);
+            return true;
+        }
+        flushHead();
+    }
+
+    if (length) {
+        WriteReq* req = new WriteReq;
+        if (buffer) {
+            req->buffer = buffer;
+        } else {
+            req->data.swap(str);
+            data = req->data.data();
+        }
+        send(req, data, length, isChunked_);
+    }
+    if (numQueued_ >= HIGH_WATER_MARK) {
+        needDrain_ = true;
+        return false;
+    } else {
+        return true;
+    }
+}
+
+void ServerResponseImpl::flushHead() {
+    isChunked_ = !getHeader(CONTENT_LENGTH);
+    if (isChunked_)
+        setHeader(TRANSFER_ENCODING, CHUNKED);
+    makeHead();
+    isHeadSent_ = true;
+
+    WriteReq* req = new WriteReq;
+    req->data.swap(res_);
+    send(req, req->data.data(), req->data.length(), false);
+
+    if (!body_.empty()) {
+        req = new WriteReq;
+        req->data.swap(body_);
+        send(req, req->data.data(), req->data.length(), isChunked_);
+    }
+}
+
+void ServerResponseImpl::send(
+    WriteReq* req,
+    const char* data,
+    Size length,
+    Boolean asChunk) {
+    static char crlf[] = "\r\n";
+
+    uv_buf_t bufs[3];
+    int n = 0;
+    if (asChunk) {
+        int len = snprintf(
+            req->sizeLine,
+            sizeof(req->sizeLine),
+            "%lx\r\n",
+            static_cast<unsigned long>(length));
+        bufs[n].base = req->sizeLine;
+        bufs[n++].len = len;
+    }
+    bufs[n].base = const_cast<char*>(data);
+    bufs[n++].len = length;
+    if (asChunk) {
+        bufs[n].base = crlf;
+        bufs[n++].len = 2;
+    }
+
+    req->res = this;
+    req->length = length;
+    req->write.data = req;
     uv_tcp_t* tcp = context_->socket->getTcp();
-    uv_stream_t* stream = reinterpret_cast<uv_stream_t*>(tcp);
-    if (write && stream) {
+    int err = uv_write(
+        &req->write,
+        reinterpret_cast<uv_stream_t*>(tcp),
+        bufs,
+        n,
+        ServerResponseImpl::afterStreamWrite);
+    if (err) {
+        delete req;
+    } else {
+        numQueued_ += length;
+        numWrites_++;
+    }
+}
+
+void ServerResponseImpl::end() {
+    if (isEnded_)
+        return;
+    isEnded_ = true;
+    if (isClosed())
+        return;
+
+    if (!isHeadSent_) {
+        makeResponse();
+        makeResBuf();
+        isHeadSent_ = true;
+        uv_write_t* write = &context_->write;
+        uv_tcp_t* tcp = context_->socket->getTcp();
+        uv_stream_t* stream = reinterpret_cast<uv_stream_t*>(tcp);
         write->data = context_;
         uv_write(
             write,
@@ -39,13 +207,58 @@ void ServerResponseImpl::end() {
             &resBuf_,
             1,
             ServerResponseImpl::afterWrite);
+        return;
+    }
+
+    if (isChunked_) {
+        WriteReq* req = new WriteReq;
+        req->data = "0\r\n\r\n";
+        send(req, req->data.data(), req->data.length(), false);
     }
+    if (!numWrites_)
+        closeConnection();
 }
 
-void ServerResponseImpl::onClose(uv_handle_t* handle) {
-    ServerContext* context = static_cast<ServerContext*>(handle->data);
-    if (context)
-        delete context;
+void ServerResponseImpl::closeConnection() {
+    if (context_)
+        context_->close();
+}
+
+Boolean ServerResponseImpl::isClosed() const {
+    return !context_ || context_->isClosed;
+}
+
+void ServerResponseImpl::detach() {
+    context_ = 0;
+    needDrain_ = false;
+    // as in node, 'close' tells that the connection went away before
+    // the response was ended
+    if (!isEnded_)
+        emit(EVENT_CLOSE);
+    removeAllListeners();
+}
+
+void ServerResponseImpl::afterWrite(uv_write_t* write, int status) {
+    static_cast<ServerContext*>(write->data)->close();
+}
+
+void ServerResponseImpl::afterStreamWrite(uv_write_t* write, int status) {
+    WriteReq* req = static_cast<WriteReq*>(write->data);
+    ServerResponseImpl* res = req->res;
+    res->numQueued_ -= req->length;
+    res->numWrites_--;
+    delete req;
+
+    if (res->isEnded_) {
+        if (!res->numWrites_)
+            res->closeConnection();
+    } else if (res->isClosed()) {
+        // the writes cancelled by the close are not followed by 'drain'
+    } else if (res->needDrain_ && res->numQueued_ < HIGH_WATER_MARK / 2) {
+        res->needDrain_ = false;
+        res->emit(EVENT_DRAIN);
+        process::runTickQueue();
+    }
 }
 
 }  // namespace http
@@ -3,11 +3,10 @@
 #ifndef SRC_HTTP_SERVER_RESPONSE_IMPL_H_
 #define SRC_HTTP_SERVER_RESPONSE_IMPL_H_
 
-#include <libj/string_buffer.h>
-#include <string.h>
 #include <uv.h>
 #include <string>
 
+#include "libnode/buffer.h"
 #include "libnode/http_server_response.h"
 #include "libnode/http_status.h"
 
@@ -21,10 +20,19 @@ class ServerResponseImpl : public ServerResponse {
  private:
     static const String::CPtr HEADERS;
     static const String::CPtr STATUS_CODE;
+    static const String::CPtr CONTENT_LENGTH;
+    static const String::CPtr TRANSFER_ENCODING;
+    static const String::CPtr CHUNKED;
 
  public:
     typedef LIBJ_PTR(ServerResponseImpl) Ptr;
 
+    // the largest body buffered until end()
+    static const Size BUFFERED_LENGTH = 16 * 1024;
+
+    // write() returns false while more than this is queued on the socket
+    static const Size HIGH_WATER_MARK = 64 * 1024;
+
     Boolean writeHead(Int statusCode) {
         status_ = http::Status::create(statusCode);
         if (status_) {
@@ -71,64 +79,35 @@ class ServerResponseImpl : public ServerResponse {
         getHeaders()->remove(name);
     }
 
-    void write(Object::CPtr chunk) {
-        body_->append(chunk);
-    }
+    Boolean write(Object::CPtr chunk);
 
-    void makeResponse() {
-        res_->append(String::create("HTTP/1.1 "));
-        if (status_) {
-            res_->append(String::valueOf(status_->code()));
-            res_->append(String::create(" "));
-            res_->append(status_->toString());
-            res_->append(String::create("\r\n"));
-        } else {
-            res_->append(String::create("200 OK\r\n"));
-        }
-        Int len = body_->length();
-        setHeader(
-            String::create("Content-Length"),
-            String::valueOf(len));
-        String::CPtr colon = String::create(": ");
-        String::CPtr nl = String::create("\r\n");
-        JsObject::Ptr headers = getHeaders();
-        Set::CPtr ks = headers->keySet();
-        Iterator::Ptr itr = ks->iterator();
-        while (itr->hasNext()) {
-            String::CPtr name = toCPtr<String>(itr->next());
-            String::CPtr value = toCPtr<String>(headers->get(name));
-            res_->append(name);
-            res_->append(colon);
-            res_->append(value);
-            res_->append(nl);
-        }
-        res_->append(nl);
-        res_->append(body_);
-    }
+    void end();
+
+    // serializes the head and the buffered body into res_
+    void makeResponse();
 
-    // TODO(plenluno): introduce Buffer
     void makeResBuf() {
-        Size len = res_->length();
-        std::string r;
-        for (Size i = 0; i < len; i++) {
-            r += static_cast<char>(res_->charAt(i));
-        }
-        resBuf_.base = static_cast<char*>(malloc(len));
-        resBuf_.len = len;
-        strncpy(resBuf_.base, r.c_str(), len);
+        resBuf_.base = res_.empty() ? 0 : &res_[0];
+        resBuf_.len = res_.length();
     }
 
-    void end();
+    // called once the connection is closed, by either side. later
+    // writes return false, and 'close' is emitted.
+    void detach();
 
  private:
-    static void onClose(uv_handle_t* handle);
+    struct WriteReq;
 
-    static void afterWrite(uv_write_t* write, int status) {
-        write->handle->data = write->data;
-        uv_close(
-            reinterpret_cast<uv_handle_t*>(write->handle),
-            ServerResponseImpl::onClose);
-    }
+    static void afterWrite(uv_write_t* write, int status);
+
+    static void afterStreamWrite(uv_write_t* write, int status);
+
+    void makeHead();
+    void flushHead();
+    void send(
+        WriteReq* req, const char* data, Size length, Boolean asChunk);
+    void closeConnection();
+    Boolean isClosed() const;
 
  private:
     ServerContext* context_;
@@ -136,17 +115,21 @@ class ServerResponseImpl : public ServerResponse {
 
     http::Status::CPtr status_;
 
-    // TODO(plenluno): introduce Buffer
-    StringBuffer::Ptr res_;
-    StringBuffer::Ptr body_;
+    std::string res_;
+    std::string body_;
+
+    Boolean isHeadSent_;
+    Boolean isChunked_;
+    Boolean isEnded_;
+    Boolean needDrain_;
+    Size numQueued_;
+    Size numWrites_;
 
     EventEmitter::Ptr ee_;
 
  public:
     ServerResponseImpl(ServerContext* context);
 
-    ~ServerResponseImpl();
-
     LIBNODE_EVENT_EMITTER_IMPL(ee_);
 };
 
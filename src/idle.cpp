@@ -0,0 +1,191 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <uv.h>
+#include <functional>
+#include <map>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "libnode/timer.h"
+#include "./record_pool.h"
+#include "./tick_queue.h"
+
+namespace libj {
+namespace node {
+
+namespace {
+    // a prepare handle notes how many callbacks have run before the loop
+    // polls for I/O, and a check handle compares after the poll. if none
+    // has run, the loop is idle, and queued tasks are run, highest
+    // priority first, until the time slice is used up. otherwise only
+    // the tasks past their deadline are run. an idle handle keeps the
+    // poll from blocking while tasks are queued.
+
+    const uint64_t TIME_SLICE_NS = 2 * 1000 * 1000;
+
+    struct IdleRecord {
+        IdleRecord* next;
+        UInt slot;
+        UInt generation;
+        bool isActive;
+        bool isCleared;
+        int64_t deadline;
+        JsFunction::Ptr callback;
+        JsArray::Ptr args;
+    };
+
+    struct IdleQueue {
+        IdleRecord* head;
+        IdleRecord* tail;
+    };
+
+    typedef std::map<Int, IdleQueue, std::greater<Int> > IdleQueues;
+
+    // deadlines are kept in a heap, and entries of records that have
+    // already run are discarded when they come to the top
+    typedef std::pair<int64_t, Value> Deadline;
+
+    struct LaterDeadline {
+        bool operator()(const Deadline& lhs, const Deadline& rhs) const {
+            return lhs.first > rhs.first;
+        }
+    };
+
+    typedef std::priority_queue<
+        Deadline, std::vector<Deadline>, LaterDeadline> Deadlines;
+
+    RecordPool<IdleRecord> records;
+    IdleQueues queues;
+    Deadlines deadlines;
+    Size numPending = 0;
+
+    bool isInitialized = false;
+    uv_prepare_t prepare;
+    uv_check_t check;
+    uv_idle_t idle;
+    Size callbacksBeforePoll = 0;
+
+    void invoke(IdleRecord* r) {
+        r->isCleared = true;
+        numPending--;
+        (*r->callback)(r->args);
+        process::runTickQueue();
+    }
+
+    // runs the first task of the highest priority,
+    // or returns false if none is left
+    bool runNext() {
+        while (!queues.empty()) {
+            IdleQueues::iterator itr = queues.begin();
+            IdleQueue& q = itr->second;
+            IdleRecord* r = q.head;
+            q.head = r->next;
+            if (!q.head)
+                queues.erase(itr);
+
+            bool isCleared = r->isCleared;
+            if (!isCleared)
+                invoke(r);
+            records.release(r);
+            if (!isCleared)
+                return true;
+        }
+        return false;
+    }
+
+    // runs the tasks past their deadline. they stay queued, and are
+    // freed when they come to the head of their queues.
+    void runOverdue(int64_t now) {
+        while (!deadlines.empty() && deadlines.top().first <= now) {
+            Value id = deadlines.top().second;
+            deadlines.pop();
+            IdleRecord* r = records.get(id);
+            if (r && !r->isCleared)
+                invoke(r);
+        }
+    }
+
+    void stopIfDone() {
+        if (numPending)
+            return;
+        uv_prepare_stop(&prepare);
+        uv_check_stop(&check);
+        uv_idle_stop(&idle);
+        while (!queues.empty())
+            runNext();
+        deadlines = Deadlines();
+    }
+
+    void onPrepare(uv_prepare_t* handle, int status) {
+        callbacksBeforePoll = process::numCallbacks();
+    }
+
+    void onCheck(uv_check_t* handle, int status) {
+        if (process::numCallbacks() == callbacksBeforePoll) {
+            uint64_t start = uv_hrtime();
+            while (runNext() && uv_hrtime() - start < TIME_SLICE_NS) {}
+        }
+        runOverdue(uv_now(uv_default_loop()));
+        stopIfDone();
+    }
+
+    void onIdle(uv_idle_t* handle, int status) {
+    }
+}
+
+Value requestIdleCallback(
+    JsFunction::Ptr callback,
+    JsArray::Ptr args,
+    Int timeout,
+    Int priority) {
+    if (!callback)
+        return Value();
+
+    uv_loop_t* loop = uv_default_loop();
+    if (!isInitialized) {
+        uv_prepare_init(loop, &prepare);
+        uv_check_init(loop, &check);
+        uv_idle_init(loop, &idle);
+        isInitialized = true;
+    }
+    if (!numPending) {
+        uv_prepare_start(&prepare, onPrepare);
+        uv_check_start(&check, onCheck);
+        uv_idle_start(&idle, onIdle);
+    }
+
+    IdleRecord* r = records.alloc();
+    r->isCleared = false;
+    r->deadline = timeout > 0 ? uv_now(loop) + timeout : 0;
+    r->callback = callback;
+    r->args = args;
+    numPending++;
+
+    IdleQueues::iterator itr = queues.find(priority);
+    if (itr == queues.end()) {
+        IdleQueue q = { r, r };
+        queues.insert(std::make_pair(priority, q));
+    } else {
+        itr->second.tail->next = r;
+        itr->second.tail = r;
+    }
+
+    Value id = records.id(r);
+    if (r->deadline)
+        deadlines.push(Deadline(r->deadline, id));
+    return id;
+}
+
+void cancelIdleCallback(Value idleId) {
+    // the record is left in its queue, and freed when it comes to the head
+    IdleRecord* r = records.get(idleId);
+    if (!r || r->isCleared)
+        return;
+    r->isCleared = true;
+    numPending--;
+    stopIfDone();
+}
+
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,98 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <uv.h>
+
+#include "libnode/timer.h"
+#include "./record_pool.h"
+#include "./tick_queue.h"
+
+namespace libj {
+namespace node {
+
+namespace {
+    // immediates are queued in a FIFO and run in batches from a single
+    // check handle, right after the loop has polled for I/O. an idle
+    // handle is kept running while the queue is not empty, so that the
+    // poll does not block.
+
+    struct ImmediateRecord {
+        ImmediateRecord* next;
+        UInt slot;
+        UInt generation;
+        bool isActive;
+        bool isCleared;
+        JsFunction::Ptr callback;
+        JsArray::Ptr args;
+    };
+
+    RecordPool<ImmediateRecord> records;
+
+    ImmediateRecord* head = 0;
+    ImmediateRecord* tail = 0;
+
+    bool isInitialized = false;
+    uv_check_t check;
+    uv_idle_t idle;
+
+    void onIdle(uv_idle_t* handle, int status) {
+    }
+
+    void onCheck(uv_check_t* handle, int status) {
+        // immediates set while running the batch wait for the next one
+        ImmediateRecord* r = head;
+        head = 0;
+        tail = 0;
+
+        while (r) {
+            ImmediateRecord* next = r->next;
+            if (!r->isCleared) {
+                r->isCleared = true;
+                (*r->callback)(r->args);
+                process::runTickQueue();
+            }
+            records.release(r);
+            r = next;
+        }
+
+        if (!head) {
+            uv_check_stop(&check);
+            uv_idle_stop(&idle);
+        }
+    }
+}
+
+Value setImmediate(JsFunction::Ptr callback, JsArray::Ptr args) {
+    if (!callback)
+        return Value();
+
+    uv_loop_t* loop = uv_default_loop();
+    if (!isInitialized) {
+        uv_check_init(loop, &check);
+        uv_idle_init(loop, &idle);
+        isInitialized = true;
+    }
+
+    ImmediateRecord* r = records.alloc();
+    r->isCleared = false;
+    r->callback = callback;
+    r->args = args;
+    if (tail) {
+        tail->next = r;
+    } else {
+        head = r;
+        uv_check_start(&check, onCheck);
+        uv_idle_start(&idle, onIdle);
+    }
+    tail = r;
+    return records.id(r);
+}
+
+void clearImmediate(Value immediateId) {
+    // the record is left in the queue, and freed when its batch runs
+    ImmediateRecord* r = records.get(immediateId);
+    if (r)
+        r->isCleared = true;
+}
+
+}  // namespace node
+}  // namespace libj
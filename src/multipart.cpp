@@ -0,0 +1,482 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <string.h>
+#include <string>
+
+#include "libnode/multipart.h"
+#include "./buffer_codec.h"
+#include "./buffer_search.h"
+
+namespace libj {
+namespace node {
+namespace multipart {
+
+const Parser::EventId Parser::EVENT_PART =
+    intern(String::create("part"));
+const Parser::EventId Parser::EVENT_DATA =
+    intern(String::create("data"));
+const Parser::EventId Parser::EVENT_PART_END =
+    intern(String::create("partEnd"));
+const Parser::EventId Parser::EVENT_END =
+    intern(String::create("end"));
+const Parser::EventId Parser::EVENT_ERROR =
+    intern(String::create("error"));
+const Parser::EventId Parser::EVENT_DRAIN =
+    intern(String::create("drain"));
+
+static const Size kMaxBoundaryLength = 70;
+static const Size kMaxHeaderSize = 16 * 1024;
+
+static Boolean isSpace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static String::CPtr decode(const std::string& s) {
+    const UByte* bytes = reinterpret_cast<const UByte*>(s.data());
+    if (codec::validUtf8Prefix(bytes, s.length()) == s.length())
+        return String::create(s.data(), String::UTF8, s.length());
+
+    Buffer::Ptr buf = Buffer::create(s.length());
+    memcpy(const_cast<void*>(buf->data()), s.data(), s.length());
+    return buf->toString(Buffer::UTF8);
+}
+
+static std::string trim(const std::string& s, Size start, Size end) {
+    while (start < end && isSpace(s[start]))
+        start++;
+    while (end > start && isSpace(s[end - 1]))
+        end--;
+    return s.substr(start, end - start);
+}
+
+class ParserImpl;
+
+// listens for 'drain' on a destination whose write() returned false
+class ParserDrain : LIBJ_JS_FUNCTION(ParserDrain)
+ public:
+    explicit ParserDrain(ParserImpl* parser) : parser_(parser) {}
+
+    Value operator()(JsArray::Ptr args);
+
+ private:
+    // the parser removes the listener before it goes away
+    ParserImpl* parser_;
+};
+
+class ParserImpl : public Parser {
+ private:
+    // after a delimiter comes '--' if it is the closing one, and
+    // otherwise optional padding and a CRLF
+    enum State {
+        PREAMBLE,
+        DELIMITER,
+        DELIMITER_DASH,
+        DELIMITER_CR,
+        HEADERS,
+        BODY,
+        EPILOGUE,
+        FAILED
+    };
+
+ public:
+    static Ptr create(String::CPtr boundary) {
+        LIBJ_NULL_PTR(Parser, nullp);
+        if (!boundary)
+            return nullp;
+
+        Size len = boundary->length();
+        if (!len || len > kMaxBoundaryLength)
+            return nullp;
+        for (Size i = 0; i < len; i++) {
+            Char c = boundary->charAt(i);
+            if (c < 0x20 || c > 0x7e)
+                return nullp;
+        }
+
+        Ptr p(new ParserImpl(boundary->toStdString()));
+        return p;
+    }
+
+    ~ParserImpl() {
+        stopWaiting();
+    }
+
+    Boolean write(Buffer::CPtr chunk) {
+        if (state_ == EPILOGUE || state_ == FAILED || isEnded_)
+            return false;
+        if (!chunk)
+            return true;
+
+        const UByte* src = static_cast<const UByte*>(chunk->data());
+        Size len = chunk->length();
+        Size i = 0;
+        while (i < len && state_ != EPILOGUE && state_ != FAILED) {
+            switch (state_) {
+            case PREAMBLE:
+            case BODY:
+                i = scanBody(chunk, src, i, len);
+                break;
+            case HEADERS:
+                i = scanHeaders(src, i, len);
+                break;
+            default:
+                scanDelimiter(src[i++]);
+            }
+        }
+        return state_ != FAILED && !drainDest_;
+    }
+
+    void end() {
+        if (isEnded_)
+            return;
+        isEnded_ = true;
+        if (state_ != EPILOGUE && state_ != FAILED)
+            fail(UNEXPECTED_END);
+        dest_.reset();
+    }
+
+    void pipe(stream::Writable::Ptr dest) {
+        if (state_ == BODY)
+            dest_ = dest;
+    }
+
+ private:
+    // emits the data up to the next delimiter, which may begin in
+    // 'tail_', the bytes held back from the last chunk, and returns
+    // where it stops in 'src'
+    Size scanBody(
+        Buffer::CPtr chunk, const UByte* src, Size start, Size len) {
+        const UByte* delim =
+            reinterpret_cast<const UByte*>(delimiter_.data());
+        Size n = delimiter_.length();
+        Size avail = len - start;
+
+        if (!tail_.empty()) {
+            // the few bytes where a delimiter from the tail would end
+            // are joined to it and searched as a copy
+            Size t = tail_.length();
+            Size more = avail < n - 1 ? avail : n - 1;
+            std::string s(tail_);
+            s.append(reinterpret_cast<const char*>(src + start), more);
+            const UByte* bytes = reinterpret_cast<const UByte*>(s.data());
+            Size pos = search::indexOf(bytes, s.length(), delim, n);
+            if (pos != NO_POS && (pos < t || more == avail)) {
+                tail_.clear();
+                emitData(bytes, pos);
+                return foundDelimiter(start + pos + n - t);
+            } else if (more == avail) {
+                Size keep = heldBack(bytes, s.length());
+                emitData(bytes, keep);
+                tail_.assign(s, keep, s.length() - keep);
+                return len;
+            }
+            emitData(reinterpret_cast<const UByte*>(tail_.data()), t);
+            tail_.clear();
+        }
+
+        Size pos = search::indexOf(src + start, avail, delim, n);
+        if (pos != NO_POS) {
+            emitData(chunk, start, start + pos);
+            return foundDelimiter(start + pos + n);
+        }
+
+        Size keep = heldBack(src + start, avail);
+        emitData(chunk, start, start + keep);
+        tail_.assign(reinterpret_cast<const char*>(src + start + keep),
+            avail - keep);
+        return len;
+    }
+
+    // where the longest end of 'src' which may begin a delimiter starts.
+    // the boundary has no CR, so only the last CR can begin one.
+    Size heldBack(const UByte* src, Size len) {
+        Size n = delimiter_.length() - 1;
+        Size from = len > n ? len - n : 0;
+        Size cr = search::lastIndexOf(src + from, len - from, '\r');
+        if (cr == NO_POS)
+            return len;
+
+        cr += from;
+        if (memcmp(src + cr, delimiter_.data(), len - cr))
+            return len;
+        return cr;
+    }
+
+    Size foundDelimiter(Size next) {
+        if (state_ == BODY) {
+            endDest();
+            emit(EVENT_PART_END);
+        }
+        state_ = DELIMITER;
+        return next;
+    }
+
+    void scanDelimiter(UByte c) {
+        switch (state_) {
+        case DELIMITER:
+            if (c == '-') {
+                state_ = DELIMITER_DASH;
+            } else if (c == '\r') {
+                state_ = DELIMITER_CR;
+            } else if (!isSpace(c)) {
+                fail(MALFORMED_BOUNDARY);
+            }
+            break;
+        case DELIMITER_DASH:
+            if (c == '-') {
+                state_ = EPILOGUE;
+                emit(EVENT_END);
+            } else {
+                fail(MALFORMED_BOUNDARY);
+            }
+            break;
+        default:
+            if (c == '\n') {
+                // a part without headers starts with the empty line,
+                // which then ends the block as well
+                header_.assign("\r\n");
+                state_ = HEADERS;
+            } else {
+                fail(MALFORMED_BOUNDARY);
+            }
+        }
+    }
+
+    // collects the header block up to the empty line, and returns where
+    // it stops in 'src'
+    Size scanHeaders(const UByte* src, Size start, Size len) {
+        static const UByte blank[] = { '\r', '\n', '\r', '\n' };
+
+        Size old = header_.length();
+        Size more = len - start;
+        if (more > kMaxHeaderSize + 4 - old)
+            more = kMaxHeaderSize + 4 - old;
+        header_.append(reinterpret_cast<const char*>(src + start), more);
+
+        Size from = old > 3 ? old - 3 : 0;
+        Size pos = search::indexOf(
+            reinterpret_cast<const UByte*>(header_.data()) + from,
+            header_.length() - from,
+            blank,
+            4);
+        if (pos == NO_POS) {
+            if (header_.length() >= kMaxHeaderSize + 4)
+                fail(HEADER_TOO_LARGE);
+            return start + more;
+        }
+
+        pos += from;
+        header_.resize(pos);
+        JsObject::Ptr headers = parseHeaders();
+        if (!headers) {
+            fail(MALFORMED_HEADER);
+            return len;
+        }
+
+        state_ = BODY;
+        emit(EVENT_PART, headers);
+        return start + pos + 4 - old;
+    }
+
+    // 'header_' without the empty line, and with the CRLF before the
+    // first header. folded lines are joined with a space, and repeated
+    // headers with ', '.
+    JsObject::Ptr parseHeaders() {
+        LIBJ_NULL_PTR(JsObject, nullp);
+        JsObject::Ptr headers = JsObject::create();
+        std::string name;
+        std::string value;
+        Size len = header_.length();
+        Size i = 2;
+        while (i <= len) {
+            Size eol = header_.find("\r\n", i);
+            if (eol == std::string::npos)
+                eol = len;
+
+            if (i < eol && isSpace(header_[i]) && !name.empty()) {
+                value.push_back(' ');
+                value.append(trim(header_, i, eol));
+            } else if (i < eol) {
+                if (!name.empty())
+                    putHeader(headers, name, value);
+                Size colon = header_.find(':', i);
+                if (colon == std::string::npos || colon >= eol)
+                    return nullp;
+                name = trim(header_, i, colon);
+                value = trim(header_, colon + 1, eol);
+                if (name.empty())
+                    return nullp;
+            }
+            i = eol + 2;
+        }
+        if (!name.empty())
+            putHeader(headers, name, value);
+        return headers;
+    }
+
+    static void putHeader(
+        JsObject::Ptr headers,
+        const std::string& name,
+        const std::string& value) {
+        String::CPtr key = decode(name)->toLowerCase();
+        String::CPtr val = decode(value);
+        String::CPtr prev = headers->getCPtr<String>(key);
+        if (prev)
+            val = prev->concat(String::create(", "))->concat(val);
+        headers->put(key, val);
+    }
+
+    void emitData(Buffer::CPtr chunk, Size start, Size end) {
+        if (state_ != BODY || start == end)
+            return;
+        if (dest_) {
+            writeDest(chunk->slice(start, end));
+        } else if (hasListeners(EVENT_DATA)) {
+            emit(EVENT_DATA, chunk->slice(start, end));
+        }
+    }
+
+    void emitData(const UByte* src, Size len) {
+        if (state_ != BODY || !len)
+            return;
+        if (!dest_ && !hasListeners(EVENT_DATA))
+            return;
+
+        Buffer::Ptr buf = Buffer::create(len);
+        memcpy(const_cast<void*>(buf->data()), src, len);
+        if (dest_) {
+            writeDest(buf);
+        } else {
+            emit(EVENT_DATA, buf);
+        }
+    }
+
+    void fail(Error err) {
+        state_ = FAILED;
+        tail_.clear();
+        header_.clear();
+        endDest();
+        emit(EVENT_ERROR, static_cast<Int>(err));
+    }
+
+    // a destination over its high water mark makes write() return false
+    // until it emits 'drain', which is then emitted by the parser
+    void writeDest(Buffer::CPtr buf) {
+        if (!dest_->write(buf) && !drainDest_) {
+            drainDest_ = dest_;
+            drainDest_->on(stream::Writable::EVENT_DRAIN, onDrain_);
+        }
+    }
+
+    // as nothing more is written to an ended destination, there is
+    // nothing to wait for once it is ended
+    void endDest() {
+        if (dest_) {
+            stopWaiting();
+            dest_->end();
+            dest_.reset();
+        }
+    }
+
+    void stopWaiting() {
+        if (drainDest_) {
+            drainDest_->removeListener(stream::Writable::EVENT_DRAIN, onDrain_);
+            drainDest_.reset();
+        }
+    }
+
+ public:
+    void onDrain() {
+        stopWaiting();
+        emit(EVENT_DRAIN);
+    }
+
+ private:
+
+    // the first delimiter may come at the very start of the body, which
+    // is as if the CRLF before it were held back from a previous chunk
+    explicit ParserImpl(const std::string& boundary)
+        : state_(PREAMBLE)
+        , isEnded_(false)
+        , delimiter_("\r\n--" + boundary)
+        , tail_("\r\n")
+        , dest_(LIBJ_NULL(stream::Writable))
+        , drainDest_(LIBJ_NULL(stream::Writable))
+        , onDrain_(new ParserDrain(this))
+        , ee_(EventEmitter::create()) {}
+
+    State state_;
+    Boolean isEnded_;
+    std::string delimiter_;
+    std::string tail_;
+    std::string header_;
+    stream::Writable::Ptr dest_;
+    stream::Writable::Ptr drainDest_;
+    JsFunction::Ptr onDrain_;
+    EventEmitter::Ptr ee_;
+
+ public:
+    LIBNODE_EVENT_EMITTER_IMPL(ee_);
+};
+
+Value ParserDrain::operator()(JsArray::Ptr args) {
+    parser_->onDrain();
+    return 0;
+}
+
+Parser::Ptr Parser::create(String::CPtr boundary) {
+    return ParserImpl::create(boundary);
+}
+
+String::CPtr boundaryOf(String::CPtr contentType) {
+    LIBJ_NULL_CPTR(String, nullp);
+    if (!contentType)
+        return nullp;
+
+    std::string s = contentType->toStdString();
+    Size len = s.length();
+    Size i = s.find(';');
+    while (i != std::string::npos && i < len) {
+        Size eq = s.find('=', i + 1);
+        if (eq == std::string::npos)
+            break;
+        Size semi = s.find(';', i + 1);
+        if (semi < eq) {
+            i = semi;
+            continue;
+        }
+
+        std::string key = trim(s, i + 1, eq);
+        Size j = eq + 1;
+        while (j < len && isSpace(s[j]))
+            j++;
+        std::string value;
+        Size next;
+        if (j < len && s[j] == '"') {
+            next = s.find('"', j + 1);
+            if (next == std::string::npos)
+                return nullp;
+            value = s.substr(j + 1, next - j - 1);
+            next = s.find(';', next);
+        } else {
+            next = s.find(';', j);
+            value = trim(s, j, next == std::string::npos ? len : next);
+        }
+
+        for (Size k = 0; k < key.length(); k++) {
+            if (key[k] >= 'A' && key[k] <= 'Z')
+                key[k] += 'a' - 'A';
+        }
+        if (key == "boundary") {
+            if (value.empty())
+                return nullp;
+            return String::create(value.data(), String::UTF8, value.length());
+        }
+        i = next;
+    }
+    return nullp;
+}
+
+}  // namespace multipart
+}  // namespace node
+}  // namespace libj
@@ -23,7 +23,7 @@ class SocketImpl : public Socket {
         return p;
     }
 
-    SocketImpl() {
+    SocketImpl() : ee_(EventEmitter::create()) {
         uv_tcp_init(uv_default_loop(), &tcp_);
     }
 
@@ -3,11 +3,13 @@
 #include <uv.h>
 
 #include "libnode/node.h"
+#include "./tick_queue.h"
 
 namespace libj {
 namespace node {
 
 void run() {
+    process::runTickQueue();
     uv_run(uv_default_loop());
 }
 
@@ -0,0 +1,63 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <vector>
+
+#include "libnode/process.h"
+#include "./tick_queue.h"
+
+namespace libj {
+namespace node {
+namespace process {
+
+namespace {
+    struct Tick {
+        JsFunction::Ptr callback;
+        JsArray::Ptr args;
+    };
+
+    // the queue is only cleared once drained, so its entries are
+    // allocated once and reused from then on
+    std::vector<Tick> ticks;
+    Size numTicks = 0;
+    bool isRunning = false;
+    Size numCalls = 0;
+}
+
+void nextTick(JsFunction::Ptr callback, JsArray::Ptr args) {
+    if (!callback)
+        return;
+
+    if (numTicks == ticks.size())
+        ticks.push_back(Tick());
+    Tick& tick = ticks[numTicks++];
+    tick.callback = callback;
+    tick.args = args;
+}
+
+void runTickQueue() {
+    numCalls++;
+    if (isRunning || !numTicks)
+        return;
+
+    static const JsFunction::Ptr nullFunc = LIBJ_NULL(JsFunction);
+    static const JsArray::Ptr nullArgs = LIBJ_NULL(JsArray);
+
+    isRunning = true;
+    for (Size i = 0; i < numTicks; i++) {
+        JsFunction::Ptr callback = ticks[i].callback;
+        JsArray::Ptr args = ticks[i].args;
+        ticks[i].callback = nullFunc;
+        ticks[i].args = nullArgs;
+        (*callback)(args);
+    }
+    numTicks = 0;
+    isRunning = false;
+}
+
+Size numCallbacks() {
+    return numCalls;
+}
+
+}  // namespace process
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,222 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <libj/js_array.h>
+#include <string.h>
+#include <string>
+
+#include "libnode/buffer.h"
+#include "libnode/querystring.h"
+#include "./buffer_codec.h"
+#include "./buffer_search.h"
+
+namespace libj {
+namespace node {
+namespace querystring {
+
+namespace {
+    const char kHex[] = "0123456789ABCDEF";
+
+    struct Unreserved {
+        Boolean is[256];
+
+        Unreserved() {
+            static const char marks[] = "-_.!~*'()";
+            for (Size c = 0; c < 256; c++) {
+                is[c] = (c >= 'a' && c <= 'z')
+                    || (c >= 'A' && c <= 'Z')
+                    || (c >= '0' && c <= '9');
+            }
+            for (Size i = 0; marks[i]; i++)
+                is[static_cast<UByte>(marks[i])] = true;
+        }
+    };
+
+    const Unreserved& unreserved() {
+        static const Unreserved u;
+        return u;
+    }
+
+    String::CPtr toString(const char* data, Size len) {
+        if (!len)
+            return String::create();
+
+        const UByte* bytes = reinterpret_cast<const UByte*>(data);
+        if (codec::validUtf8Prefix(bytes, len) == len)
+            return String::create(data, String::UTF8, len);
+
+        // escapes can make any bytes, so they are sanitized like Buffers
+        Buffer::Ptr buf = Buffer::create(len);
+        memcpy(const_cast<void*>(buf->data()), data, len);
+        return buf->toString(Buffer::UTF8);
+    }
+
+    // the runs between escapes are found a block at a time, so that
+    // a string without any is made into a String as it is
+    String::CPtr decode(const char* data, Size len) {
+        static const UByte escapes[] = { '%', '+' };
+
+        const UByte* src = reinterpret_cast<const UByte*>(data);
+        Size k = search::indexOfAny(src, len, escapes, 2);
+        if (k == NO_POS)
+            return toString(data, len);
+
+        std::string s;
+        s.reserve(len);
+        Size pos = 0;
+        while (k != NO_POS) {
+            s.append(data + pos, k);
+            pos += k;
+
+            UByte c;
+            if (data[pos] == '+') {
+                s.push_back(' ');
+                pos++;
+            } else if (pos + 2 < len &&
+                       codec::hexDecode(data + pos + 1, 2, &c)) {
+                s.push_back(static_cast<char>(c));
+                pos += 3;
+            } else {
+                s.push_back('%');
+                pos++;
+            }
+            k = search::indexOfAny(src + pos, len - pos, escapes, 2);
+        }
+        s.append(data + pos, len - pos);
+        return toString(s.data(), s.length());
+    }
+
+    void appendEscaped(std::string* out, String::CPtr str) {
+        if (!str)
+            return;
+
+        const Boolean* is = unreserved().is;
+        std::string s = str->toStdString();
+        Size len = s.length();
+        out->reserve(out->length() + len);
+        for (Size i = 0; i < len; i++) {
+            UByte c = static_cast<UByte>(s[i]);
+            if (is[c]) {
+                out->push_back(static_cast<char>(c));
+            } else {
+                out->push_back('%');
+                out->push_back(kHex[c >> 4]);
+                out->push_back(kHex[c & 0x0f]);
+            }
+        }
+    }
+
+    void appendPair(
+        std::string* out,
+        String::CPtr key,
+        const Value& value,
+        Char sep,
+        Char eq) {
+        if (!out->empty())
+            out->push_back(static_cast<char>(sep));
+        appendEscaped(out, key);
+        out->push_back(static_cast<char>(eq));
+
+        String::CPtr s = toCPtr<String>(value);
+        appendEscaped(out, s ? s : String::valueOf(value));
+    }
+
+    void add(JsObject::Ptr obj, String::CPtr key, String::CPtr value) {
+        if (!obj->containsKey(key)) {
+            obj->put(key, value);
+            return;
+        }
+
+        Value v = obj->get(key);
+        JsArray::Ptr values = toPtr<JsArray>(v);
+        if (!values) {
+            values = JsArray::create();
+            values->add(v);
+            obj->put(key, values);
+        }
+        values->add(value);
+    }
+}
+
+JsObject::Ptr parse(String::CPtr str, Char sep, Char eq, Size maxKeys) {
+    JsObject::Ptr obj = JsObject::create();
+    if (!str)
+        return obj;
+
+    std::string s = str->toStdString();
+    const char* data = s.data();
+    const UByte* src = reinterpret_cast<const UByte*>(data);
+    Size len = s.length();
+
+    // a single scan for either delimiter ends the key, and then one for
+    // 'sep' alone ends the value
+    const UByte delims[] = {
+        static_cast<UByte>(sep),
+        static_cast<UByte>(eq)
+    };
+    Size pos = 0;
+    Size pairs = 0;
+    while (pos < len && (!maxKeys || pairs < maxKeys)) {
+        Size k = search::indexOfAny(src + pos, len - pos, delims, 2);
+        Size keyEnd = k == NO_POS ? len : pos + k;
+        Size valueStart = keyEnd;
+        Size end = keyEnd;
+        if (keyEnd < len && src[keyEnd] == delims[1]) {
+            valueStart = keyEnd + 1;
+            k = search::indexOf(src + valueStart, len - valueStart, delims[0]);
+            end = k == NO_POS ? len : valueStart + k;
+        }
+
+        if (end > pos) {
+            add(obj,
+                decode(data + pos, keyEnd - pos),
+                decode(data + valueStart, end - valueStart));
+            pairs++;
+        }
+        pos = end + 1;
+    }
+    return obj;
+}
+
+String::CPtr stringify(JsObject::CPtr obj, Char sep, Char eq) {
+    if (!obj)
+        return String::create();
+
+    std::string s;
+    Set::CPtr ks = obj->keySet();
+    Iterator::Ptr itr = ks->iterator();
+    while (itr->hasNext()) {
+        Value k = itr->next();
+        String::CPtr key = toCPtr<String>(k);
+        if (!key)
+            key = String::valueOf(k);
+
+        Value v = obj->get(k);
+        JsArray::CPtr values = toCPtr<JsArray>(v);
+        if (values) {
+            Size n = values->size();
+            for (Size i = 0; i < n; i++)
+                appendPair(&s, key, values->get(i), sep, eq);
+        } else {
+            appendPair(&s, key, v, sep, eq);
+        }
+    }
+    return String::create(s.data(), String::UTF8, s.length());
+}
+
+String::CPtr escape(String::CPtr str) {
+    std::string s;
+    appendEscaped(&s, str);
+    return String::create(s.data(), String::UTF8, s.length());
+}
+
+String::CPtr unescape(String::CPtr str) {
+    if (!str)
+        return String::create();
+
+    std::string s = str->toStdString();
+    return decode(s.data(), s.length());
+}
+
+}  // namespace querystring
+}  // namespace node
+}  // namespace libj
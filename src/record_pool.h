@@ -0,0 +1,96 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef SRC_RECORD_POOL_H_
+#define SRC_RECORD_POOL_H_
+
+#include <libj/js_array.h>
+#include <libj/js_function.h>
+#include <libj/string.h>
+#include <vector>
+
+namespace libj {
+namespace node {
+
+// records of type T allocated in blocks and recycled through a free list.
+// a record is identified by a Value made of its slot and a generation
+// count bumped on every release, so a stale id never resolves to
+// a recycled record.
+//
+// T needs the members 'T* next', 'UInt slot', 'UInt generation',
+// 'bool isActive', 'JsFunction::Ptr callback' and 'JsArray::Ptr args'.
+// 'next' is free for other use while allocated.
+template<typename T>
+class RecordPool {
+ public:
+    RecordPool() : free_(0) {}
+
+    ~RecordPool() {
+        for (Size i = 0; i < blocks_.size(); i++)
+            delete[] blocks_[i];
+    }
+
+    T* alloc() {
+        if (!free_) {
+            UInt base = static_cast<UInt>(blocks_.size()) << BLOCK_BITS;
+            T* block = new T[BLOCK_SIZE];
+            blocks_.push_back(block);
+            for (UInt i = BLOCK_SIZE; i > 0; i--) {
+                T* r = &block[i - 1];
+                r->slot = base + i - 1;
+                r->generation = 0;
+                r->isActive = false;
+                r->next = free_;
+                free_ = r;
+            }
+        }
+        T* r = free_;
+        free_ = r->next;
+        r->next = 0;
+        r->isActive = true;
+        return r;
+    }
+
+    // the callback and its arguments are let go of on release, not when
+    // the record is reused
+    void release(T* r) {
+        static const JsFunction::Ptr nullFunc = LIBJ_NULL(JsFunction);
+        static const JsArray::Ptr nullArgs = LIBJ_NULL(JsArray);
+        r->callback = nullFunc;
+        r->args = nullArgs;
+        r->isActive = false;
+        r->generation++;
+        r->next = free_;
+        free_ = r;
+    }
+
+    Value id(const T* r) const {
+        return (static_cast<Long>(r->generation) << 32) |
+               (static_cast<Long>(r->slot) + 1);
+    }
+
+    T* get(const Value& id) const {
+        Long l;
+        if (!to<Long>(id, &l))
+            return 0;
+        UInt slot = static_cast<UInt>(l & 0xffffffff) - 1;
+        UInt generation = static_cast<UInt>(l >> 32);
+        if ((slot >> BLOCK_BITS) >= blocks_.size())
+            return 0;
+        T* r = &blocks_[slot >> BLOCK_BITS][slot & (BLOCK_SIZE - 1)];
+        if (!r->isActive || r->generation != generation)
+            return 0;
+        return r;
+    }
+
+ private:
+    static const UInt BLOCK_BITS = 10;
+    static const UInt BLOCK_SIZE = 1 << BLOCK_BITS;
+
+    std::vector<T*> blocks_;
+    T* free_;
+};
+
+}  // namespace node
+}  // namespace libj
+
+#endif  // SRC_RECORD_POOL_H_
@@ -0,0 +1,16 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include "libnode/stream_writable.h"
+
+namespace libj {
+namespace node {
+namespace stream {
+
+const Writable::EventId Writable::EVENT_DRAIN =
+    intern(String::create("drain"));
+const Writable::EventId Writable::EVENT_CLOSE =
+    intern(String::create("close"));
+
+}  // namespace stream
+}  // namespace node
+}  // namespace libj
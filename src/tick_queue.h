@@ -0,0 +1,24 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef SRC_TICK_QUEUE_H_
+#define SRC_TICK_QUEUE_H_
+
+#include <libj/string.h>
+
+namespace libj {
+namespace node {
+namespace process {
+
+// runs the callbacks queued by nextTick, including those queued while
+// running. to be called whenever a libnode callback returns to the loop.
+void runTickQueue();
+
+// the number of calls to runTickQueue() so far, which tells whether
+// any callback has run in between
+Size numCallbacks();
+
+}  // namespace process
+}  // namespace node
+}  // namespace libj
+
+#endif  // SRC_TICK_QUEUE_H_
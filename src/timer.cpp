@@ -2,100 +2,348 @@
 
 #include <uv.h>
 #include <map>
+#include <vector>
 
 #include "libnode/timer.h"
+#include "./record_pool.h"
+#include "./tick_queue.h"
 
 namespace libj {
 namespace node {
 
 namespace {
-    Int nextTimeoutId = 1;
-    Int nextIntervalId = -1;
+    // timers are grouped into one list per duration, sorted by expiry,
+    // and only the head of a list needs an underlying uv timer. as the
+    // timers of a list share the same duration, a new timer nearly always
+    // goes at the tail, so setting and clearing a timer are O(1) apart
+    // from the lookup of its list among the distinct durations.
 
-    struct TimerContext {
-        Int id;
-        uv_timer_t timer;
-        int64_t timeout;
+    struct TimerList;
+
+    struct TimerRecord {
+        TimerRecord* prev;
+        TimerRecord* next;
+        TimerList* list;
+        int64_t expiry;
+        Int slack;
+        UInt slot;
+        UInt generation;
+        bool isActive;
+        bool isRepeat;
+        bool isCleared;
+        bool isRefed;
         JsFunction::Ptr callback;
         JsArray::Ptr args;
-        bool isCleared;
     };
 
-    std::map<Int, TimerContext*> timers;
+    struct TimerList {
+        uv_timer_t timer;
+        Int delay;
+        Size numRefed;
+        bool isStarted;
+        bool isUnrefed;
+        bool isRunning;
+        TimerRecord* head;
+        TimerRecord* tail;
+    };
+
+    typedef std::map<Int, TimerList*> TimerLists;
 
-    void clearTimer(Value timerId) {
-        Int id;
-        if (!to<Int>(timerId, &id))
+    TimerLists lists;
+
+    // a list emptied by clearing its timers is only stopped, as the
+    // same duration is usually set again soon (e.g. request timeouts),
+    // unless there are more lists than this
+    const Size MAX_LISTS = 64;
+
+    RecordPool<TimerRecord> records;
+
+    void onList(uv_timer_t* handle, int status);
+
+    void onListClose(uv_handle_t* handle) {
+        delete static_cast<TimerList*>(handle->data);
+    }
+
+    // a started list keeps the loop alive unless all of its timers
+    // are unrefed, in which case its reference is given back
+    void updateRef(TimerList* list) {
+        bool unref = list->isStarted && !list->numRefed;
+        if (unref == list->isUnrefed)
             return;
-        std::map<Int, TimerContext*>::const_iterator itr = timers.find(id);
-        if (itr != timers.end()) {
-            TimerContext* context = itr->second;
-            uv_timer_stop(&context->timer);
-            timers.erase(id);
-            delete context;
+        if (unref) {
             uv_unref(uv_default_loop());
+        } else {
+            uv_ref(uv_default_loop());
+        }
+        list->isUnrefed = unref;
+    }
+
+    void stop(TimerList* list) {
+        if (list->isStarted) {
+            uv_timer_stop(&list->timer);
+            list->isStarted = false;
+        }
+        updateRef(list);
+    }
+
+    // with a slack, the wakeup is rounded up to a multiple of it,
+    // so that timers due at nearby times share a single wakeup
+    int64_t wakeup(TimerRecord* r) {
+        if (r->slack <= 1)
+            return r->expiry;
+        return (r->expiry + r->slack - 1) / r->slack * r->slack;
+    }
+
+    // the wakeup of the head, or earlier if a timer due before it would
+    // be late then, such as one without a slack. only the timers due
+    // within the head's slack are looked at.
+    int64_t wakeup(TimerList* list) {
+        int64_t t = wakeup(list->head);
+        for (TimerRecord* r = list->head->next;
+             r && r->expiry < t;
+             r = r->next) {
+            int64_t w = wakeup(r);
+            if (w < t)
+                t = w;
+        }
+        return t;
+    }
+
+    void arm(TimerList* list) {
+        if (list->isRunning)
+            return;
+        if (!list->head) {
+            stop(list);
+            return;
+        }
+
+        int64_t timeout = wakeup(list) - uv_now(uv_default_loop());
+        if (timeout < 0)
+            timeout = 0;
+        if (list->isStarted)
+            uv_timer_stop(&list->timer);
+        uv_timer_start(&list->timer, onList, timeout, 0);
+        list->isStarted = true;
+        updateRef(list);
+    }
+
+    TimerList* getList(Int delay) {
+        TimerLists::const_iterator itr = lists.find(delay);
+        if (itr != lists.end())
+            return itr->second;
+
+        TimerList* list = new TimerList;
+        list->delay = delay;
+        list->numRefed = 0;
+        list->isStarted = false;
+        list->isUnrefed = false;
+        list->isRunning = false;
+        list->head = 0;
+        list->tail = 0;
+        uv_timer_init(uv_default_loop(), &list->timer);
+        list->timer.data = list;
+        lists[delay] = list;
+        return list;
+    }
+
+    void releaseList(TimerList* list) {
+        if (list->head || list->isRunning)
+            return;
+        lists.erase(list->delay);
+        stop(list);
+        uv_close(reinterpret_cast<uv_handle_t*>(&list->timer), onListClose);
+    }
+
+    bool isLinked(TimerRecord* r) {
+        return r->prev || r->next || r->list->head == r;
+    }
+
+    // inserts in expiry order, searching from the tail
+    void insert(TimerList* list, TimerRecord* r) {
+        TimerRecord* prev = list->tail;
+        while (prev && prev->expiry > r->expiry)
+            prev = prev->prev;
+
+        r->list = list;
+        r->prev = prev;
+        r->next = prev ? prev->next : list->head;
+        if (r->next) {
+            r->next->prev = r;
+        } else {
+            list->tail = r;
+        }
+        if (prev) {
+            prev->next = r;
+        } else {
+            list->head = r;
+        }
+
+        if (r->isRefed)
+            list->numRefed++;
+        if (list->head == r) {
+            arm(list);
+        } else if (!list->isRunning) {
+            updateRef(list);
         }
     }
 
-    void onTimeout(uv_timer_t* handle, int status) {
-        TimerContext* context = static_cast<TimerContext*>(handle->data);
-        if (!context->isCleared)
-            (*context->callback)(context->args);
-        clearTimer(context->id);
+    // leaves the list armed for the old head, if any, as rearming costs
+    // more than the odd early wakeup
+    void unlink(TimerRecord* r) {
+        TimerList* list = r->list;
+        if (r->prev) {
+            r->prev->next = r->next;
+        } else {
+            list->head = r->next;
+        }
+        if (r->next) {
+            r->next->prev = r->prev;
+        } else {
+            list->tail = r->prev;
+        }
+        r->prev = 0;
+        r->next = 0;
+
+        if (r->isRefed)
+            list->numRefed--;
+        if (list->isRunning)
+            return;
+        if (list->head) {
+            updateRef(list);
+        } else {
+            stop(list);
+        }
     }
 
-    void onInterval(uv_timer_t* handle, int status) {
-        TimerContext* context = static_cast<TimerContext*>(handle->data);
-        if (context->isCleared) {
-            clearTimer(context->id);
+    void onList(uv_timer_t* handle, int status) {
+        TimerList* list = static_cast<TimerList*>(handle->data);
+        int64_t now = uv_now(uv_default_loop());
+
+        list->isStarted = false;
+        list->isRunning = true;
+        while (list->head && list->head->expiry <= now) {
+            TimerRecord* r = list->head;
+            unlink(r);
+            // the record stays allocated while its callback runs,
+            // so the callback can clear its own id
+            (*r->callback)(r->args);
+            process::runTickQueue();
+            if (r->isRepeat && !r->isCleared) {
+                // intervals are scheduled against their previous
+                // deadline rather than the end of the callback,
+                // and skip the periods they have missed
+                r->expiry += list->delay;
+                if (r->expiry <= now) {
+                    int64_t missed = (now - r->expiry) / list->delay + 1;
+                    r->expiry += missed * list->delay;
+                }
+                insert(list, r);
+            } else {
+                records.release(r);
+            }
+        }
+        list->isRunning = false;
+
+        if (list->head) {
+            arm(list);
         } else {
-            (*context->callback)(context->args);
-            uv_timer_stop(&context->timer);
-            uv_timer_start(&context->timer, onInterval, context->timeout, 1);
+            releaseList(list);
         }
     }
 
-    Int setTimer(
-        Int id,
+    Value setTimer(
         Int delay,
         JsFunction::Ptr callback,
         JsArray::Ptr args,
-        uv_timer_cb cb) {
-        TimerContext* context = new TimerContext;
-        context->id = id;
-        context->timeout = delay < 0 ? 0 : delay;
-        context->callback = callback;
-        context->args = args;
-        context->isCleared = false;
-        timers[context->id] = context;
-        uv_timer_init(uv_default_loop(), &context->timer);
-        context->timer.data = context;
-        uv_timer_start(&context->timer, cb, context->timeout, 1);
-        return context->id;
+        bool isRepeat) {
+        if (!callback)
+            return Value();
+
+        // as in node, a delay of 0 is treated as 1ms, so that a timer
+        // set from a callback never runs in the same pass of its list
+        if (delay < 1)
+            delay = 1;
+
+        TimerRecord* r = records.alloc();
+        r->expiry = uv_now(uv_default_loop()) + delay;
+        r->slack = 0;
+        r->isRepeat = isRepeat;
+        r->isCleared = false;
+        r->isRefed = true;
+        r->callback = callback;
+        r->args = args;
+        insert(getList(delay), r);
+        return records.id(r);
+    }
+
+    void clearTimer(Value timerId) {
+        TimerRecord* r = records.get(timerId);
+        if (!r || r->isCleared)
+            return;
+
+        r->isCleared = true;
+        TimerList* list = r->list;
+        if (isLinked(r)) {
+            unlink(r);
+            records.release(r);
+            if (lists.size() > MAX_LISTS)
+                releaseList(list);
+        }
+        // otherwise its callback is running, and the record is
+        // freed when the callback returns
+    }
+
+    void setRefed(Value timerId, bool isRefed) {
+        TimerRecord* r = records.get(timerId);
+        if (!r || r->isCleared || r->isRefed == isRefed)
+            return;
+
+        r->isRefed = isRefed;
+        if (isLinked(r)) {
+            TimerList* list = r->list;
+            if (isRefed) {
+                list->numRefed++;
+            } else {
+                list->numRefed--;
+            }
+            if (!list->isRunning)
+                updateRef(list);
+        }
     }
 }
 
 Value setTimeout(JsFunction::Ptr callback, Int delay, JsArray::Ptr args) {
-    return setTimer(nextTimeoutId++, delay, callback, args, onTimeout);
+    return setTimer(delay, callback, args, false);
 }
 
 Value setInterval(JsFunction::Ptr callback, Int delay, JsArray::Ptr args) {
-    return setTimer(nextIntervalId--, delay, callback, args, onInterval);
+    return setTimer(delay, callback, args, true);
 }
 
 void clearTimeout(Value timeoutId) {
-    Int id;
-    if (!to<Int>(timeoutId, &id))
-        return;
-    std::map<Int, TimerContext*>::const_iterator itr = timers.find(id);
-    if (itr != timers.end()) {
-        TimerContext* context = itr->second;
-        context->isCleared = true;
-    }
+    clearTimer(timeoutId);
 }
 
 void clearInterval(Value intervalId) {
-    clearTimeout(intervalId);
+    clearTimer(intervalId);
+}
+
+void refTimer(Value timerId) {
+    setRefed(timerId, true);
+}
+
+void unrefTimer(Value timerId) {
+    setRefed(timerId, false);
+}
+
+void setTimerSlack(Value timerId, Int slack) {
+    TimerRecord* r = records.get(timerId);
+    if (!r || r->isCleared)
+        return;
+
+    r->slack = slack < 0 ? 0 : slack;
+    if (isLinked(r))
+        arm(r->list);
 }
 
 }  // namespace node
@@ -1,8 +1,8 @@
 // Copyright (c) 2012 Plenluno All rights reserved.
 
-#include <url_parser.h>
-
+#include "libnode/querystring.h"
 #include "libnode/url.h"
+#include "./url_parser.h"
 
 namespace libj {
 namespace node {
@@ -20,64 +20,94 @@ const String::CPtr PATH = String::create("path");
 const String::CPtr QUERY = String::create("query");
 const String::CPtr HASH = String::create("hash");
 
-JsObject::Ptr parse(String::CPtr urlStr) {
-    static const String::CPtr colon = String::create(":");
+// the characters of 'r', sharing 'str' if that is all of it
+static String::CPtr substring(
+    String::CPtr str, const Components::Range& r) {
+    if (!r.start && r.end == str->length())
+        return str;
+    return str->substring(r.start, r.end);
+}
+
+JsObject::Ptr parse(String::CPtr urlStr, Boolean parseQueryString) {
     static const String::CPtr slash = String::create("/");
-    static const String::CPtr sharp = String::create("#");
-    static const String::CPtr question = String::create("?");
 
     if (!urlStr) {
         LIBJ_NULL_PTR(JsObject, nullp);
         return nullp;
     }
 
-    struct parsed_url* url = parse_url(urlStr->toStdString().c_str());
+    Components c;
+    parseComponents(urlStr, &c);
     JsObject::Ptr obj = JsObject::create();
 
     obj->put(HREF, urlStr);
-    if (url->scheme) {
-        obj->put(PROTOCOL, String::create(url->scheme)->toLowerCase());
-    }
-    LIBJ_NULL_CPTR(String, port);
-    if (url->port) {
-        port = String::create(url->port);
-        obj->put(PORT, port);
+    if (c.protocol.exists()) {
+        String::CPtr protocol = substring(urlStr, c.protocol);
+        if (c.hasUpperCaseProtocol)
+            protocol = protocol->toLowerCase();
+        obj->put(PROTOCOL, protocol);
     }
-    if (url->host) {
-        String::CPtr hostname = String::create(url->host)->toLowerCase();
-        obj->put(HOSTNAME, hostname);
-        if (port) {
-            obj->put(HOST, hostname->concat(colon)->concat(port));
+    if (c.auth.exists())
+        obj->put(AUTH, substring(urlStr, c.auth));
+    if (c.host.exists()) {
+        String::CPtr host = substring(urlStr, c.host);
+        if (c.hasUpperCaseHost)
+            host = host->toLowerCase();
+        obj->put(HOST, host);
+
+        // the hostname is a prefix of the host, unless it is bracketed
+        if (c.port.exists() || c.hostname.start != c.host.start) {
+            String::CPtr hostname = substring(urlStr, c.hostname);
+            if (c.hasUpperCaseHost)
+                hostname = hostname->toLowerCase();
+            obj->put(HOSTNAME, hostname);
         } else {
-            obj->put(HOST, hostname);
+            obj->put(HOSTNAME, host);
         }
     }
-    LIBJ_NULL_CPTR(String, query);
-    if (url->query) {
-        query = String::create(url->query);
-        obj->put(QUERY, query);
+    if (c.port.exists())
+        obj->put(PORT, substring(urlStr, c.port));
+
+    // the path runs from the pathname to the end of the search, and is
+    // taken from the string as a whole, except where the pathname of
+    // a URL with a host is empty and so '/'
+    LIBJ_NULL_CPTR(String, pathname);
+    if (c.pathname.exists()) {
+        pathname = substring(urlStr, c.pathname);
+    } else if (c.hasAuthority) {
+        pathname = slash;
     }
-    if (url->path) {
-        String::CPtr pathname = slash->concat(String::create(url->path));
+    if (pathname)
         obj->put(PATHNAME, pathname);
-        if (query) {
-            obj->put(PATH, pathname->concat(question)->concat(query));
+    if (c.search.exists()) {
+        String::CPtr search = substring(urlStr, c.search);
+        obj->put(SEARCH, search);
+        Components::Range query = c.search;
+        query.start++;
+        String::CPtr queryStr = substring(urlStr, query);
+        if (parseQueryString) {
+            obj->put(QUERY, querystring::parse(queryStr));
         } else {
-            obj->put(PATH, pathname);
+            obj->put(QUERY, queryStr);
         }
-    }
-    if (url->username && url->password) {
-        String::CPtr auth = String::create(url->username);
-        auth = auth->concat(colon);
-        auth = auth->concat(String::create(url->password));
-        obj->put(AUTH, auth);
-    }
-    if (url->fragment) {
-        String::CPtr hash = sharp->concat(String::create(url->fragment));
-        obj->put(HASH, hash);
-    }
 
-    parsed_url_free(url);
+        Components::Range path = c.search;
+        if (c.pathname.exists()) {
+            path.start = c.pathname.start;
+            obj->put(PATH, substring(urlStr, path));
+        } else if (pathname) {
+            obj->put(PATH, pathname->concat(search));
+        } else {
+            obj->put(PATH, search);
+        }
+    } else {
+        if (parseQueryString)
+            obj->put(QUERY, JsObject::create());
+        if (pathname)
+            obj->put(PATH, pathname);
+    }
+    if (c.hash.exists())
+        obj->put(HASH, substring(urlStr, c.hash));
     return obj;
 }
 
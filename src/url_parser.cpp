@@ -0,0 +1,154 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include "./url_parser.h"
+
+namespace libj {
+namespace node {
+namespace url {
+
+static Boolean isAlpha(Char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static Boolean isSchemeChar(Char c) {
+    return isAlpha(c)
+        || (c >= '0' && c <= '9')
+        || c == '+'
+        || c == '-'
+        || c == '.';
+}
+
+static Boolean isUpperCase(Char c) {
+    return c >= 'A' && c <= 'Z';
+}
+
+static Boolean hasUpperCase(String::CPtr str, Size start, Size end) {
+    for (Size i = start; i < end; i++) {
+        if (isUpperCase(str->charAt(i)))
+            return true;
+    }
+    return false;
+}
+
+static void setRange(Components::Range* r, Size start, Size end) {
+    r->start = start;
+    r->end = end;
+}
+
+// the end of the scheme 'str' starts with, or 0 if it has none
+static Size scanScheme(String::CPtr str, Size len) {
+    if (!len || !isAlpha(str->charAt(0)))
+        return 0;
+
+    Size i = 1;
+    while (i < len && isSchemeChar(str->charAt(i)))
+        i++;
+    return i < len && str->charAt(i) == ':' ? i : 0;
+}
+
+// '[userinfo@]host[:port]' from 'start', up to the path, the query or
+// the fragment. returns where it ends.
+static Size scanAuthority(
+    String::CPtr str, Size start, Size len, Components* c) {
+    Size at = NO_POS;
+    Size colon = NO_POS;
+    Size bracket = NO_POS;
+    Size i = start;
+    for (; i < len; i++) {
+        Char ch = str->charAt(i);
+        if (ch == '/' || ch == '?' || ch == '#') {
+            break;
+        } else if (ch == '@') {
+            at = i;
+            colon = NO_POS;
+            bracket = NO_POS;
+        } else if (ch == ':') {
+            colon = i;
+        } else if (ch == ']') {
+            bracket = i;
+        }
+    }
+
+    Size hostStart = start;
+    if (at != NO_POS) {
+        setRange(&c->auth, start, at);
+        hostStart = at + 1;
+    }
+
+    // a colon inside the brackets of an IPv6 address is not the port's
+    if (colon != NO_POS && bracket != NO_POS && colon < bracket)
+        colon = NO_POS;
+
+    Size hostEnd = colon != NO_POS ? colon : i;
+    if (colon != NO_POS && colon + 1 < i) {
+        setRange(&c->port, colon + 1, i);
+        setRange(&c->host, hostStart, i);
+    } else {
+        setRange(&c->host, hostStart, hostEnd);
+    }
+
+    if (hostEnd > hostStart + 1 &&
+        str->charAt(hostStart) == '[' &&
+        str->charAt(hostEnd - 1) == ']') {
+        setRange(&c->hostname, hostStart + 1, hostEnd - 1);
+    } else {
+        setRange(&c->hostname, hostStart, hostEnd);
+    }
+    c->hasUpperCaseHost = hasUpperCase(str, hostStart, hostEnd);
+    return i;
+}
+
+void parseComponents(String::CPtr str, Components* c) {
+    Components::Range none = { NO_POS, NO_POS };
+    c->protocol = none;
+    c->auth = none;
+    c->host = none;
+    c->hostname = none;
+    c->port = none;
+    c->pathname = none;
+    c->search = none;
+    c->hash = none;
+    c->hasAuthority = false;
+    c->hasUpperCaseProtocol = false;
+    c->hasUpperCaseHost = false;
+
+    Size len = str->length();
+    Size i = 0;
+
+    // origin-form targets such as '/path?query' have neither a scheme
+    // nor an authority, and go straight to the path
+    if (!len || str->charAt(0) != '/') {
+        Size colon = scanScheme(str, len);
+        if (colon) {
+            setRange(&c->protocol, 0, colon);
+            c->hasUpperCaseProtocol = hasUpperCase(str, 0, colon);
+            i = colon + 1;
+            if (i + 1 < len &&
+                str->charAt(i) == '/' &&
+                str->charAt(i + 1) == '/') {
+                c->hasAuthority = true;
+                i = scanAuthority(str, i + 2, len, c);
+            }
+        }
+    }
+
+    Size start = i;
+    Char ch = 0;
+    while (i < len && (ch = str->charAt(i)) != '?' && ch != '#')
+        i++;
+    if (i > start)
+        setRange(&c->pathname, start, i);
+
+    if (i < len && ch == '?') {
+        start = i;
+        while (++i < len && str->charAt(i) != '#') {}
+        setRange(&c->search, start, i);
+    }
+
+    if (i < len)
+        setRange(&c->hash, i, len);
+}
+
+}  // namespace url
+}  // namespace node
+}  // namespace libj
@@ -0,0 +1,48 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#ifndef SRC_URL_PARSER_H_
+#define SRC_URL_PARSER_H_
+
+#include <libj/string.h>
+
+namespace libj {
+namespace node {
+namespace url {
+
+// the components of a URL as ranges of the characters of the string
+// parsed, found in a single pass without allocating, so that only the
+// components asked for are made into Strings
+struct Components {
+    struct Range {
+        Size start;
+        Size end;
+
+        Boolean exists() const {
+            return start != NO_POS;
+        }
+    };
+
+    Range protocol;  // without the ':'
+    Range auth;      // 'user:password'
+    Range host;      // 'hostname:port'
+    Range hostname;  // without the brackets of an IPv6 address
+    Range port;
+    Range pathname;
+    Range search;    // with the '?'
+    Range hash;      // with the '#'
+
+    // true if there is a '//' authority, even if it is empty
+    Boolean hasAuthority;
+
+    // true if the protocol or the host has uppercase letters
+    Boolean hasUpperCaseProtocol;
+    Boolean hasUpperCaseHost;
+};
+
+void parseComponents(String::CPtr str, Components* c);
+
+}  // namespace url
+}  // namespace node
+}  // namespace libj
+
+#endif  // SRC_URL_PARSER_H_
@@ -0,0 +1,181 @@
+// Copyright (c) 2012 Plenluno All rights reserved.
+
+#include <string>
+
+#include "libnode/url.h"
+#include "./buffer_codec.h"
+
+namespace libj {
+namespace node {
+namespace url {
+
+static Int hexValue(Char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static Boolean isUpperHex(Char c) {
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F');
+}
+
+// the unreserved characters of RFC 3986, which need no escaping
+static Boolean isUnreserved(Char c) {
+    return (c >= 'a' && c <= 'z')
+        || (c >= 'A' && c <= 'Z')
+        || (c >= '0' && c <= '9')
+        || c == '-'
+        || c == '.'
+        || c == '_'
+        || c == '~';
+}
+
+static Boolean isDotSegment(String::CPtr path, Size start, Size end) {
+    Size n = end - start;
+    return (n == 1 && path->charAt(start) == '.')
+        || (n == 2 && path->charAt(start) == '.'
+                   && path->charAt(start + 1) == '.');
+}
+
+// true if normalizePath() would return 'path' as it is. a single pass
+// over the characters, without allocating.
+static Boolean isCanonical(String::CPtr path) {
+    Size len = path->length();
+    if (!len || path->charAt(0) != '/')
+        return false;
+
+    Size segment = 1;
+    for (Size i = 1; i <= len; i++) {
+        Char c = i < len ? path->charAt(i) : '/';
+        if (c == '/') {
+            if (i == segment && i < len)
+                return false;
+            if (isDotSegment(path, segment, i))
+                return false;
+            segment = i + 1;
+        } else if (c == '%') {
+            if (i + 2 >= len ||
+                !isUpperHex(path->charAt(i + 1)) ||
+                !isUpperHex(path->charAt(i + 2)))
+                return false;
+            Char v = (hexValue(path->charAt(i + 1)) << 4)
+                | hexValue(path->charAt(i + 2));
+            if (isUnreserved(v))
+                return false;
+            i += 2;
+        }
+    }
+    return true;
+}
+
+// appends the segment to 'out', which ends with a '/', or resolves it
+// if it is '.' or '..'. false if '..' would go above the root.
+static Boolean appendSegment(
+    std::string* out, const std::string& seg, Boolean isLast) {
+    if (seg.empty() || seg == ".") {
+        return true;
+    } else if (seg == "..") {
+        if (out->length() == 1)
+            return false;
+        out->resize(out->rfind('/', out->length() - 2) + 1);
+        return true;
+    } else {
+        out->append(seg);
+        if (!isLast)
+            out->push_back('/');
+        return true;
+    }
+}
+
+String::CPtr normalizePath(String::CPtr path) {
+    LIBJ_NULL_CPTR(String, nullp);
+    if (!path)
+        return nullp;
+    if (isCanonical(path))
+        return path;
+
+    static const char hex[] = "0123456789ABCDEF";
+
+    std::string s = path->toStdString();
+    Size len = s.length();
+    std::string out("/");
+    std::string seg;
+    out.reserve(len + 1);
+    for (Size i = 0; i < len; i++) {
+        char c = s[i];
+        if (c == '/') {
+            if (!appendSegment(&out, seg, false))
+                return nullp;
+            seg.clear();
+        } else if (c == '%') {
+            Int hi = i + 2 < len ? hexValue(s[i + 1]) : -1;
+            Int lo = i + 2 < len ? hexValue(s[i + 2]) : -1;
+            if (hi < 0 || lo < 0)
+                return nullp;
+
+            // escaped dots are decoded before the dot segments are
+            // resolved, so that '%2E%2E' can't get past the root
+            Char v = (hi << 4) | lo;
+            if (isUnreserved(v)) {
+                seg.push_back(static_cast<char>(v));
+            } else {
+                seg.push_back('%');
+                seg.push_back(hex[hi]);
+                seg.push_back(hex[lo]);
+            }
+            i += 2;
+        } else {
+            seg.push_back(c);
+        }
+    }
+    if (!appendSegment(&out, seg, true))
+        return nullp;
+    return String::create(out.data(), String::UTF8, out.length());
+}
+
+String::CPtr toFilePath(String::CPtr root, String::CPtr path) {
+    LIBJ_NULL_CPTR(String, nullp);
+    if (!root)
+        return nullp;
+
+    String::CPtr normalized = normalizePath(path);
+    if (!normalized)
+        return nullp;
+
+    Size rootLen = root->length();
+    if (rootLen && root->charAt(rootLen - 1) == '/')
+        root = root->substring(0, rootLen - 1);
+    if (normalized->indexOf('%') == NO_POS)
+        return root->concat(normalized);
+
+    // the escapes left are of reserved characters, which name files as
+    // they are, except for the separators and NUL
+    std::string s = normalized->toStdString();
+    Size len = s.length();
+    std::string out;
+    out.reserve(len);
+    for (Size i = 0; i < len; i++) {
+        if (s[i] != '%') {
+            out.push_back(s[i]);
+            continue;
+        }
+
+        char c = static_cast<char>(
+            (hexValue(s[i + 1]) << 4) | hexValue(s[i + 2]));
+        if (c == '/' || c == '\\' || c == '\0')
+            return nullp;
+        out.push_back(c);
+        i += 2;
+    }
+
+    const UByte* bytes = reinterpret_cast<const UByte*>(out.data());
+    if (codec::validUtf8Prefix(bytes, out.length()) != out.length())
+        return nullp;
+    return root->concat(
+        String::create(out.data(), String::UTF8, out.length()));
+}
+
+}  // namespace url
+}  // namespace node
+}  // namespace libj
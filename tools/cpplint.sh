@@ -1,2 +1,2 @@
 #!/bin/sh
-tools/cpplint/cpplint.py --filter=-runtime/explicit,-readability/streams include/libnode/* src/* gtest/* sample/*
+tools/cpplint/cpplint.py --filter=-runtime/explicit,-readability/streams include/libnode/* src/* gtest/* sample/* bench/*